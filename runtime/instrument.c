@@ -0,0 +1,241 @@
+// Reference host implementation of the `sil --instrument-functions` hooks.
+//
+// Every instrumented function calls __sil_enter(fn_id) on entry and
+// __sil_exit(fn_id) before returning. This implementation timestamps both
+// with the cycle counter, keeps a shadow call stack and prints a flat and a
+// call-graph profile to stderr (or $SIL_INSTRUMENT_FILE) at exit:
+//
+//     gcc program.o runtime/instrument.c -o program
+//
+// Function names come from the sil_fn_names section the compiler emits. The
+// hooks are single threaded; board implementations usually replace
+// read_cycles() with DWT->CYCCNT or a timer and stream events instead.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+#define MAX_FUNCTIONS 1024
+#define MAX_EDGES 4096
+#define MAX_DEPTH 256
+#define ROOT_ID 0
+
+typedef struct FnName {
+    uint32_t id;
+    const char* name;
+} FnName;
+
+extern const FnName __start_sil_fn_names[] __attribute__((weak));
+extern const FnName __stop_sil_fn_names[] __attribute__((weak));
+
+typedef struct FnStats {
+    uint32_t id;
+    uint64_t calls;
+    uint64_t total_cycles;
+    uint64_t self_cycles;
+} FnStats;
+
+typedef struct EdgeStats {
+    uint32_t caller;
+    uint32_t callee;
+    uint64_t calls;
+    uint64_t total_cycles;
+} EdgeStats;
+
+typedef struct Frame {
+    uint32_t id;
+    uint64_t start;
+    uint64_t child_cycles;
+} Frame;
+
+static FnStats functions[MAX_FUNCTIONS];
+static EdgeStats edges[MAX_EDGES];
+static Frame stack[MAX_DEPTH];
+// keeps counting past MAX_DEPTH, so the exits of calls that found the stack
+// full do not pop frames of the calls below them
+static int depth;
+static int overflow;
+
+static inline uint64_t read_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static uint32_t slot(uint32_t a, uint32_t b, uint32_t size) {
+    return (a * 2654435761u ^ b * 40503u) % size;
+}
+
+static FnStats* function_stats(uint32_t id) {
+    for (uint32_t i = 0, index = slot(id, 0, MAX_FUNCTIONS); i < MAX_FUNCTIONS; i++) {
+        FnStats* stats = &functions[(index + i) % MAX_FUNCTIONS];
+        if (stats->calls == 0 || stats->id == id) {
+            stats->id = id;
+            return stats;
+        }
+    }
+    return NULL;
+}
+
+static EdgeStats* edge_stats(uint32_t caller, uint32_t callee) {
+    for (uint32_t i = 0, index = slot(caller, callee, MAX_EDGES); i < MAX_EDGES; i++) {
+        EdgeStats* stats = &edges[(index + i) % MAX_EDGES];
+        if (stats->calls == 0 || (stats->caller == caller && stats->callee == callee)) {
+            stats->caller = caller;
+            stats->callee = callee;
+            return stats;
+        }
+    }
+    return NULL;
+}
+
+void __sil_enter(uint32_t fn_id) {
+    if (depth >= MAX_DEPTH) {
+        depth += 1;
+        overflow = 1;
+        return;
+    }
+
+    Frame* frame = &stack[depth];
+    depth += 1;
+    frame->id = fn_id;
+    frame->child_cycles = 0;
+    frame->start = read_cycles();
+}
+
+void __sil_exit(uint32_t fn_id) {
+    uint64_t end = read_cycles();
+    if (depth > MAX_DEPTH) {
+        depth -= 1;
+        return;
+    }
+    if (depth == 0 || stack[depth - 1].id != fn_id) {
+        overflow = 1;
+        return;
+    }
+
+    depth -= 1;
+    Frame* frame = &stack[depth];
+    uint64_t cycles = end - frame->start;
+    uint32_t caller = depth > 0 ? stack[depth - 1].id : ROOT_ID;
+    if (depth > 0) {
+        stack[depth - 1].child_cycles += cycles;
+    }
+
+    FnStats* stats = function_stats(fn_id);
+    EdgeStats* edge = edge_stats(caller, fn_id);
+    if (stats == NULL || edge == NULL) {
+        overflow = 1;
+        return;
+    }
+
+    stats->calls += 1;
+    stats->total_cycles += cycles;
+    stats->self_cycles += cycles - frame->child_cycles;
+    edge->calls += 1;
+    edge->total_cycles += cycles;
+}
+
+static const char* fn_name(uint32_t id) {
+    if (id == ROOT_ID) {
+        return "<root>";
+    }
+
+    for (const FnName* entry = __start_sil_fn_names; entry < __stop_sil_fn_names; entry++) {
+        if (entry->id == id) {
+            return entry->name;
+        }
+    }
+    return "<unknown>";
+}
+
+static int compare_self_cycles(const void* a, const void* b) {
+    const FnStats* left = a;
+    const FnStats* right = b;
+    if (left->self_cycles == right->self_cycles) {
+        return 0;
+    }
+    return left->self_cycles < right->self_cycles ? 1 : -1;
+}
+
+static int compare_edges(const void* a, const void* b) {
+    const EdgeStats* left = a;
+    const EdgeStats* right = b;
+    if (left->caller != right->caller) {
+        return left->caller < right->caller ? -1 : 1;
+    }
+    if (left->total_cycles == right->total_cycles) {
+        return 0;
+    }
+    return left->total_cycles < right->total_cycles ? 1 : -1;
+}
+
+__attribute__((destructor))
+static void print_profile(void) {
+    FILE* out = stderr;
+    const char* path = getenv("SIL_INSTRUMENT_FILE");
+    if (path != NULL && path[0] != 0) {
+        out = fopen(path, "w");
+        if (out == NULL) {
+            out = stderr;
+        }
+    }
+
+    uint64_t total_self = 0;
+    for (int i = 0; i < MAX_FUNCTIONS; i++) {
+        total_self += functions[i].self_cycles;
+    }
+
+    qsort(functions, MAX_FUNCTIONS, sizeof(FnStats), compare_self_cycles);
+    fprintf(out, "Flat profile:\n");
+    fprintf(out, "%8s %14s %14s %10s  %s\n", "self%", "self cycles", "total cycles", "calls", "name");
+    for (int i = 0; i < MAX_FUNCTIONS && functions[i].calls != 0; i++) {
+        FnStats* stats = &functions[i];
+        double percent = total_self ? 100.0 * stats->self_cycles / total_self : 0;
+        fprintf(
+            out,
+            "%7.2f%% %14llu %14llu %10llu  %s\n",
+            percent,
+            (unsigned long long)stats->self_cycles,
+            (unsigned long long)stats->total_cycles,
+            (unsigned long long)stats->calls,
+            fn_name(stats->id)
+        );
+    }
+
+    qsort(edges, MAX_EDGES, sizeof(EdgeStats), compare_edges);
+    fprintf(out, "\nCall graph:\n");
+    fprintf(out, "%-24s %-24s %10s %14s\n", "caller", "callee", "calls", "total cycles");
+    for (int i = 0; i < MAX_EDGES; i++) {
+        EdgeStats* edge = &edges[i];
+        if (edge->calls == 0) {
+            continue;
+        }
+        fprintf(
+            out,
+            "%-24s %-24s %10llu %14llu\n",
+            fn_name(edge->caller),
+            fn_name(edge->callee),
+            (unsigned long long)edge->calls,
+            (unsigned long long)edge->total_cycles
+        );
+    }
+
+    if (overflow) {
+        fprintf(out, "\nwarning: tables overflowed or enter/exit were unbalanced, profile is partial\n");
+    }
+
+    if (out != stderr) {
+        fclose(out);
+    }
+}
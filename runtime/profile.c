@@ -0,0 +1,230 @@
+// Profile runtime for code built with `sil --profile-generate`.
+//
+// Writes the counters emitted by llvm's instrprof lowering in the .profraw
+// format read by `llvm-profdata merge`. On a hosted target the profile is
+// written to $LLVM_PROFILE_FILE, the --profile-generate=<file> path or
+// default.profraw when the program exits:
+//
+//     gcc program.o runtime/profile.c -o program
+//
+// Freestanding targets build with -DSIL_PROFILE_FREESTANDING and call
+// sil_profile_write() with a writer that streams the bytes out (uart, semihosting,
+// a debugger buffer...). No libc is needed in that configuration.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROFILE_RAW_MAGIC \
+    ((uint64_t)255 << 56 | (uint64_t)'l' << 48 | (uint64_t)'p' << 40 | \
+    (uint64_t)'r' << 32 | (uint64_t)'o' << 24 | (uint64_t)'f' << 16 | \
+    (uint64_t)'r' << 8 | (uint64_t)129)
+#define PROFILE_RAW_VERSION 8
+#define PROFILE_VARIANT_IR ((uint64_t)1 << 56)
+#define PROFILE_VALUE_KIND_LAST 1
+
+typedef void (*ProfileWriter)(const void* data, size_t size, void* user);
+
+// Layout of the __profd_* records emitted for every instrumented function.
+typedef struct ProfileData {
+    uint64_t name_ref;
+    uint64_t function_hash;
+    intptr_t counters;
+    intptr_t function;
+    intptr_t values;
+    uint32_t counter_count;
+    uint16_t value_site_count[PROFILE_VALUE_KIND_LAST + 1];
+} ProfileData;
+
+// Function records and name blobs the profile is built from.
+typedef struct ProfileSections {
+    const ProfileData* const* data;
+    size_t data_count;
+    const ProfileData* data_begin;
+    const char* const* names;
+    const uint64_t* names_sizes;
+    size_t names_count;
+} ProfileSections;
+
+// Defined by the instrumented module.
+extern const uint64_t __llvm_profile_raw_version __attribute__((weak));
+
+// Referenced by instrumented code on targets without linker section ranges.
+int __llvm_profile_runtime;
+
+void sil_profile_write(ProfileWriter writer, void* user);
+
+#ifdef SIL_PROFILE_FREESTANDING
+
+#ifndef SIL_PROFILE_MAX_FUNCTIONS
+#define SIL_PROFILE_MAX_FUNCTIONS 256
+#endif
+
+#ifndef SIL_PROFILE_MAX_MODULES
+#define SIL_PROFILE_MAX_MODULES 16
+#endif
+
+// Without __start_/__stop_ symbols every module registers its records from a
+// global constructor instead. Records are not guaranteed to be contiguous.
+static const ProfileData* registered_data[SIL_PROFILE_MAX_FUNCTIONS];
+static size_t registered_data_count;
+static const char* registered_names[SIL_PROFILE_MAX_MODULES];
+static uint64_t registered_names_sizes[SIL_PROFILE_MAX_MODULES];
+static size_t registered_names_count;
+
+void __llvm_profile_register_function(void* data) {
+    // the runtime hook variable is registered alongside the records
+    if (data == &__llvm_profile_runtime) {
+        return;
+    }
+
+    if (registered_data_count < SIL_PROFILE_MAX_FUNCTIONS) {
+        registered_data[registered_data_count] = data;
+        registered_data_count += 1;
+    }
+}
+
+void __llvm_profile_register_names_function(void* names, uint64_t size) {
+    if (registered_names_count < SIL_PROFILE_MAX_MODULES) {
+        registered_names[registered_names_count] = names;
+        registered_names_sizes[registered_names_count] = size;
+        registered_names_count += 1;
+    }
+}
+
+static ProfileSections profile_sections(void) {
+    return (ProfileSections){
+        registered_data,
+        registered_data_count,
+        NULL,
+        registered_names,
+        registered_names_sizes,
+        registered_names_count,
+    };
+}
+
+#else
+
+#include <stdio.h>
+#include <stdlib.h>
+
+extern const ProfileData __start___llvm_prf_data[] __attribute__((weak));
+extern const ProfileData __stop___llvm_prf_data[] __attribute__((weak));
+extern const char __start___llvm_prf_names[] __attribute__((weak));
+extern const char __stop___llvm_prf_names[] __attribute__((weak));
+
+// Set by --profile-generate=<file>.
+extern const char __llvm_profile_filename[] __attribute__((weak));
+
+static const char* linked_names[1];
+static uint64_t linked_names_sizes[1];
+
+static ProfileSections profile_sections(void) {
+    linked_names[0] = __start___llvm_prf_names;
+    linked_names_sizes[0] = __stop___llvm_prf_names - __start___llvm_prf_names;
+
+    return (ProfileSections){
+        NULL,
+        __stop___llvm_prf_data - __start___llvm_prf_data,
+        __start___llvm_prf_data,
+        linked_names,
+        linked_names_sizes,
+        1,
+    };
+}
+
+static void file_writer(const void* data, size_t size, void* user) {
+    fwrite(data, 1, size, user);
+}
+
+__attribute__((destructor))
+static void profile_write_file(void) {
+    const char* path = getenv("LLVM_PROFILE_FILE");
+    if (path == NULL || path[0] == 0) {
+        path = __llvm_profile_filename;
+    }
+    if (path == NULL || path[0] == 0) {
+        path = "default.profraw";
+    }
+
+    FILE* file = fopen(path, "wb");
+    if (file == NULL) {
+        fprintf(stderr, "sil profile: could not open %s\n", path);
+        return;
+    }
+
+    sil_profile_write(file_writer, file);
+    fclose(file);
+}
+
+#endif
+
+static const ProfileData* profile_record(ProfileSections* sections, size_t index) {
+    if (sections->data != NULL) {
+        return sections->data[index];
+    }
+    return &sections->data_begin[index];
+}
+
+static const uint64_t* profile_counters(const ProfileData* data) {
+    return (const uint64_t*)((const char*)data + data->counters);
+}
+
+static uint64_t padding_to_8(uint64_t size) {
+    return (8 - size % 8) % 8;
+}
+
+// The profile is written as if records and counters were two contiguous
+// arrays, data first, so counter pointers are rebased on the way out.
+void sil_profile_write(ProfileWriter writer, void* user) {
+    static const char zeroes[8] = {0};
+    ProfileSections sections = profile_sections();
+
+    uint64_t version = PROFILE_RAW_VERSION | PROFILE_VARIANT_IR;
+    if (&__llvm_profile_raw_version != NULL) {
+        version = __llvm_profile_raw_version;
+    }
+
+    uint64_t counter_count = 0;
+    for (size_t i = 0; i < sections.data_count; i++) {
+        counter_count += profile_record(&sections, i)->counter_count;
+    }
+
+    uint64_t names_size = 0;
+    for (size_t i = 0; i < sections.names_count; i++) {
+        names_size += sections.names_sizes[i];
+    }
+
+    uint64_t data_size = sections.data_count * sizeof(ProfileData);
+    uint64_t header[] = {
+        PROFILE_RAW_MAGIC,
+        version,
+        0, // binary ids size
+        sections.data_count,
+        0, // padding before counters
+        counter_count,
+        0, // padding after counters
+        names_size,
+        data_size, // counters start right after the records
+        (uintptr_t)sections.names[0],
+        PROFILE_VALUE_KIND_LAST,
+    };
+    writer(header, sizeof(header), user);
+
+    uint64_t counter_offset = data_size;
+    for (size_t i = 0; i < sections.data_count; i++) {
+        ProfileData data = *profile_record(&sections, i);
+        data.counters = counter_offset - i * sizeof(ProfileData);
+        counter_offset += data.counter_count * sizeof(uint64_t);
+        writer(&data, sizeof(data), user);
+    }
+
+    for (size_t i = 0; i < sections.data_count; i++) {
+        const ProfileData* data = profile_record(&sections, i);
+        writer(profile_counters(data), data->counter_count * sizeof(uint64_t), user);
+    }
+
+    for (size_t i = 0; i < sections.names_count; i++) {
+        writer(sections.names[i], sections.names_sizes[i], user);
+    }
+    writer(zeroes, padding_to_8(names_size), user);
+}
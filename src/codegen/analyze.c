@@ -17,7 +17,22 @@ static void analyze_function(CodegenContext* context, AstNode* fn) {
 }
 
 
+static void analyze_struct(CodegenContext* context, AstNode* declaration) {
+    String name = declaration->data.struct_declaration.name;
+
+    if (map_has(&context->struct_map, name)) {
+        sil_panic("Multiple struct definitions: %.*s", name.length, name.data);
+    }
+
+    map_insert(&context->struct_map, name, declaration);
+}
+
 void codegen_analyze(CodegenContext *context, AstNode *root) {
+    List* type_list = &root->data.root.type_list;
+    for (int i = 0; i < type_list->length; i++) {
+        analyze_struct(context, *list_get(AstNode*, type_list, i));
+    }
+
     List* function_list = &root->data.root.function_list;
     for (int i = 0; i < function_list->length; i++) {
         AstNode* item = *list_get(AstNode*, function_list, i);
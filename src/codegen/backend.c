@@ -0,0 +1,239 @@
+#include "backend.h"
+
+#include "codegen.h"
+#include "codegen/profile.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Analysis.h"
+#include "llvm-c/Core.h"
+#include "llvm-c/Error.h"
+#include "llvm-c/Support.h"
+#include "llvm-c/Target.h"
+#include "llvm-c/TargetMachine.h"
+#include "llvm-c/Transforms/PassBuilder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+static const char* optimization_pipeline(OptimizationLevel level) {
+    switch (level) {
+        case OptimizationLevel_O0: return "default<O0>";
+        case OptimizationLevel_O1: return "default<O1>";
+        case OptimizationLevel_O2: return "default<O2>";
+        case OptimizationLevel_O3: return "default<O3>";
+        case OptimizationLevel_Os: return "default<Os>";
+        case OptimizationLevel_Oz: return "default<Oz>";
+        default: sil_panic("Backend Error: Unknown optimization level");
+    }
+}
+
+static LLVMCodeGenOptLevel codegen_level(OptimizationLevel level) {
+    switch (level) {
+        case OptimizationLevel_O0: return LLVMCodeGenLevelNone;
+        case OptimizationLevel_O1: return LLVMCodeGenLevelLess;
+        case OptimizationLevel_O3: return LLVMCodeGenLevelAggressive;
+        default: return LLVMCodeGenLevelDefault;
+    }
+}
+
+static void parse_llvm_options(CodegenContext* context) {
+    List arguments = {0};
+    char* program = "sil";
+    list_push(char*, &arguments, &program);
+
+    profile_add_llvm_options(context, &arguments);
+
+    if (arguments.length > 1) {
+        LLVMParseCommandLineOptions(arguments.length, arguments.data, NULL);
+    }
+
+    list_delete(&arguments);
+}
+
+// LLVM only warns about a cpu the target does not know, then aborts when it
+// emits code, so the warning it prints while the target machine is created
+// is turned into an error.
+static LLVMTargetMachineRef create_target_machine(
+    LLVMTargetRef target,
+    const char* triple,
+    const char* cpu,
+    const char* features,
+    LLVMCodeGenOptLevel level,
+    LLVMRelocMode reloc_mode
+) {
+    FILE* capture = tmpfile();
+    int saved_stderr = capture != NULL ? dup(STDERR_FILENO) : -1;
+    if (saved_stderr >= 0) {
+        fflush(stderr);
+        dup2(fileno(capture), STDERR_FILENO);
+    }
+
+    LLVMTargetMachineRef machine = LLVMCreateTargetMachine(target, triple, cpu, features, level, reloc_mode, LLVMCodeModelDefault);
+
+    if (saved_stderr < 0) {
+        return machine;
+    }
+    fflush(stderr);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+
+    char messages[4096];
+    rewind(capture);
+    size_t length = fread(messages, 1, sizeof(messages) - 1, capture);
+    messages[length] = 0;
+    fclose(capture);
+
+    if (strstr(messages, "is not a recognized processor") != NULL) {
+        sil_panic("Backend Error: Unknown cpu '%s' for %s (llc -mtriple=%s -mcpu=help lists them)", cpu, triple, triple);
+    }
+    fputs(messages, stderr);
+
+    return machine;
+}
+
+void backend_init(CodegenContext* context) {
+    CodegenOptions* options = context->options;
+
+    LLVMInitializeAllTargetInfos();
+    LLVMInitializeAllTargets();
+    LLVMInitializeAllTargetMCs();
+    LLVMInitializeAllAsmPrinters();
+    LLVMInitializeAllAsmParsers();
+
+    parse_llvm_options(context);
+
+    // Code for the host is linked into position independent executables by
+    // default; embedded targets keep their static relocation model.
+    char* triple;
+    char* cpu;
+    char* features;
+    LLVMRelocMode reloc_mode;
+    if (options->target_triple == NULL) {
+        triple = LLVMGetDefaultTargetTriple();
+        cpu = LLVMGetHostCPUName();
+        features = LLVMGetHostCPUFeatures();
+        reloc_mode = LLVMRelocPIC;
+    } else {
+        triple = LLVMNormalizeTargetTriple(options->target_triple);
+        cpu = LLVMCreateMessage("generic");
+        features = LLVMCreateMessage("");
+        reloc_mode = LLVMRelocDefault;
+    }
+
+    if (options->cpu != NULL) {
+        LLVMDisposeMessage(cpu);
+        LLVMDisposeMessage(features);
+        cpu = LLVMCreateMessage(options->cpu);
+        features = LLVMCreateMessage("");
+    }
+
+    LLVMTargetRef target;
+    char* error;
+    if (LLVMGetTargetFromTriple(triple, &target, &error)) {
+        sil_panic("Backend Error: %s", error);
+    }
+
+    context->target_machine = create_target_machine(
+        target,
+        triple,
+        cpu,
+        features,
+        codegen_level(options->optimization_level),
+        reloc_mode
+    );
+
+    LLVMSetTarget(context->module, triple);
+    LLVMTargetDataRef data_layout = LLVMCreateTargetDataLayout(context->target_machine);
+    LLVMSetModuleDataLayout(context->module, data_layout);
+    LLVMDisposeTargetData(data_layout);
+
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+    LLVMDisposeMessage(features);
+}
+
+void backend_verify(CodegenContext* context) {
+    char* error;
+    if (LLVMVerifyModule(context->module, LLVMReturnStatusAction, &error)) {
+        sil_panic("Backend Error: Invalid module\n%s", error);
+    }
+    LLVMDisposeMessage(error);
+}
+
+static void run_passes(CodegenContext* context, const char* passes) {
+    LLVMPassBuilderOptionsRef pass_options = LLVMCreatePassBuilderOptions();
+    LLVMErrorRef error = LLVMRunPasses(
+        context->module,
+        passes,
+        context->target_machine,
+        pass_options
+    );
+    LLVMDisposePassBuilderOptions(pass_options);
+
+    if (error != NULL) {
+        char* message = LLVMGetErrorMessage(error);
+        sil_panic("Backend Error: %s", message);
+    }
+}
+
+void backend_optimize(CodegenContext* context) {
+    profile_emit_globals(context);
+
+    // Instrumentation and profile annotation have to see the same CFG, so
+    // both run on the module exactly as codegen produced it.
+    const char* profile_passes = profile_pipeline(context);
+    if (profile_passes != NULL) {
+        run_passes(context, profile_passes);
+
+        // the profile registration functions are created without nounwind,
+        // which pulls unwind personality routines into freestanding links
+        LLVMValueRef function = LLVMGetFirstFunction(context->module);
+        for (; function != NULL; function = LLVMGetNextFunction(function)) {
+            if (!LLVMIsDeclaration(function)) {
+                codegen_add_fn_attribute(function, "nounwind");
+            }
+        }
+    }
+
+    run_passes(context, optimization_pipeline(context->options->optimization_level));
+}
+
+// The object is kept in memory so reports can read its symbol table.
+void backend_emit(CodegenContext* context) {
+    char* error;
+    if (LLVMTargetMachineEmitToMemoryBuffer(
+        context->target_machine,
+        context->module,
+        LLVMObjectFile,
+        &error,
+        &context->object
+    )) {
+        sil_panic("Backend Error: %s", error);
+    }
+
+    FILE* file = fopen(context->options->output_path, "wb");
+    if (file == NULL) {
+        sil_panic("Backend Error: Could not open %s", context->options->output_path);
+    }
+
+    size_t size = LLVMGetBufferSize(context->object);
+    if (fwrite(LLVMGetBufferStart(context->object), 1, size, file) != size) {
+        sil_panic("Backend Error: Could not write %s", context->options->output_path);
+    }
+
+    fclose(file);
+}
+
+void backend_emit_ir(CodegenContext* context) {
+    if (context->options->ir_path == NULL) {
+        return;
+    }
+
+    char* error;
+    if (LLVMPrintModuleToFile(context->module, context->options->ir_path, &error)) {
+        sil_panic("Backend Error: Could not write %s\n%s", context->options->ir_path, error);
+    }
+}
@@ -0,0 +1,12 @@
+#ifndef CODEGEN_BACKEND_H
+#define CODEGEN_BACKEND_H
+
+typedef struct CodegenContext CodegenContext;
+
+void backend_init(CodegenContext* context);
+void backend_verify(CodegenContext* context);
+void backend_optimize(CodegenContext* context);
+void backend_emit(CodegenContext* context);
+void backend_emit_ir(CodegenContext* context);
+
+#endif
@@ -0,0 +1,522 @@
+#include "builtin.h"
+
+#include "codegen.h"
+#include "list.h"
+#include "parser/expression.h"
+#include "string_buffer.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Target.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Longest constant @memset stored as one splatted vector.
+#define BUILTIN_MEMSET_INLINE_BYTES 64
+
+
+BranchHint builtin_branch_hint(AstNode* expression) {
+    if (expression->type != AstNodeType_PrimaryExpression
+        || expression->data.primary_expression.type != PrimaryExpressionType_Symbol) {
+        return BranchHint_None;
+    }
+
+    String name = expression->data.primary_expression.function_call.name;
+    if (name.length == strlen("@likely") && string_compare_literal(name, "@likely")) {
+        return BranchHint_Likely;
+    }
+    if (name.length == strlen("@unlikely") && string_compare_literal(name, "@unlikely")) {
+        return BranchHint_Unlikely;
+    }
+    return BranchHint_None;
+}
+
+static Value builtin_void(CodegenContext* context) {
+    return (Value){ NULL, type_void(context) };
+}
+
+static String builtin_name(AstNode* fn_call) {
+    return fn_call->data.primary_expression.function_call.name;
+}
+
+static AstNode* builtin_argument(AstNode* fn_call, size_t count, size_t index) {
+    String name = builtin_name(fn_call);
+    List* arguments = &fn_call->data.primary_expression.function_call.parameters;
+    if (arguments->length != count) {
+        sil_panic("Code Gen Error: %.*s takes %zu arguments, got %zu", name.length, name.data, count, arguments->length);
+    }
+    return *list_get(AstNode*, arguments, index);
+}
+
+static Value builtin_vector_argument(CodegenContext* context, AstNode* fn_call, size_t count, size_t index, Type* expected) {
+    String name = builtin_name(fn_call);
+    Value value = codegen_expression(context, builtin_argument(fn_call, count, index), expected);
+    if (value.type->kind != TypeKind_Vector) {
+        sil_panic("Code Gen Error: %.*s needs a vector, got %.*s", name.length, name.data, value.type->name.length, value.type->name.data);
+    }
+    return value;
+}
+
+// an integer, or a vector of them
+static Value builtin_integer_argument(CodegenContext* context, AstNode* fn_call, size_t count, size_t index, Type* expected) {
+    String name = builtin_name(fn_call);
+    Value value = codegen_expression(context, builtin_argument(fn_call, count, index), expected);
+    if (type_element(value.type)->kind != TypeKind_Int) {
+        sil_panic("Code Gen Error: %.*s needs an integer, got %.*s", name.length, name.data, value.type->name.length, value.type->name.data);
+    }
+    return value;
+}
+
+static Value builtin_pointer_argument(CodegenContext* context, AstNode* fn_call, size_t count, size_t index) {
+    String name = builtin_name(fn_call);
+    Value value = codegen_expression(context, builtin_argument(fn_call, count, index), NULL);
+    // a slice, a string literal above all, passes its data pointer
+    if (value.type->kind == TypeKind_Slice) {
+        LLVMValueRef data = LLVMBuildExtractValue(context->builder, value.llvm_value, 0, "");
+        value = (Value){ data, type_pointer(context, value.type->child) };
+    }
+    if (value.type->kind != TypeKind_Pointer) {
+        sil_panic("Code Gen Error: %.*s needs a pointer, got %.*s", name.length, name.data, value.type->name.length, value.type->name.data);
+    }
+    return value;
+}
+
+static LLVMValueRef builtin_constant_argument(CodegenContext* context, AstNode* fn_call, size_t count, size_t index, Type* type) {
+    String name = builtin_name(fn_call);
+    Value value = codegen_expression(context, builtin_argument(fn_call, count, index), type);
+    value = codegen_coerce(context, value, type);
+    if (!LLVMIsConstant(value.llvm_value)) {
+        sil_panic("Code Gen Error: %.*s argument %zu must be a constant", name.length, name.data, index + 1);
+    }
+    return value.llvm_value;
+}
+
+// Memory intrinsics take untyped pointers; the pointee gives the alignment.
+static LLVMValueRef byte_pointer(CodegenContext* context, Value pointer, unsigned int* alignment) {
+    Type* pointee = pointer.type->child;
+    *alignment = pointee->kind == TypeKind_Void
+        ? 1
+        : LLVMABIAlignmentOfType(LLVMGetModuleDataLayout(context->module), pointee->llvm_type);
+    return LLVMBuildPointerCast(context->builder, pointer.llvm_value, LLVMPointerType(LLVMInt8Type(), 0), "");
+}
+
+static void set_argument_alignment(LLVMValueRef call, unsigned int index, unsigned int alignment) {
+    unsigned int kind = LLVMGetEnumAttributeKindForName("align", strlen("align"));
+    LLVMAttributeRef align = LLVMCreateEnumAttribute(LLVMGetGlobalContext(), kind, alignment);
+    LLVMAddCallSiteAttribute(call, index + 1, align);
+}
+
+// outside an if condition the hint becomes llvm.expect
+static Value builtin_branch_expect(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    Type* bool_type = type_bool(context);
+    Value condition = codegen_expression(context, builtin_argument(fn_call, 1, 0), bool_type);
+    condition = codegen_coerce(context, condition, bool_type);
+
+    LLVMTypeRef overload = bool_type->llvm_type;
+    LLVMValueRef arguments[] = {
+        condition.llvm_value,
+        LLVMConstInt(bool_type->llvm_type, builtin_branch_hint(fn_call) == BranchHint_Likely, 0),
+    };
+    return (Value){ codegen_intrinsic_call(context, "llvm.expect", &overload, 1, arguments, 2), bool_type };
+}
+
+// @expect(x, value) tells the optimizer x is usually value
+static Value builtin_expect(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value value = codegen_expression(context, builtin_argument(fn_call, 2, 0), expected);
+    if (value.type->kind != TypeKind_Int && value.type->kind != TypeKind_Bool) {
+        sil_panic("Code Gen Error: @expect needs an integer or bool, got %.*s", value.type->name.length, value.type->name.data);
+    }
+
+    LLVMTypeRef overload = value.type->llvm_type;
+    LLVMValueRef arguments[] = {
+        value.llvm_value,
+        builtin_constant_argument(context, fn_call, 2, 1, value.type),
+    };
+    return (Value){ codegen_intrinsic_call(context, "llvm.expect", &overload, 1, arguments, 2), value.type };
+}
+
+// @assume(condition) lets the optimizer rely on condition being true
+static Value builtin_assume(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    Type* bool_type = type_bool(context);
+    Value condition = codegen_expression(context, builtin_argument(fn_call, 1, 0), bool_type);
+    condition = codegen_coerce(context, condition, bool_type);
+
+    codegen_intrinsic_call(context, "llvm.assume", NULL, 0, &condition.llvm_value, 1);
+    return builtin_void(context);
+}
+
+static Value builtin_unary_intrinsic(CodegenContext* context, AstNode* fn_call, Type* expected, const char* intrinsic) {
+    Value value = builtin_integer_argument(context, fn_call, 1, 0, expected);
+    LLVMTypeRef overload = value.type->llvm_type;
+    return (Value){ codegen_intrinsic_call(context, intrinsic, &overload, 1, &value.llvm_value, 1), value.type };
+}
+
+static Value builtin_popcount(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    return builtin_unary_intrinsic(context, fn_call, expected, "llvm.ctpop");
+}
+
+static Value builtin_bswap(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value value = builtin_integer_argument(context, fn_call, 1, 0, expected);
+    if (value.type->bits % 16 != 0) {
+        sil_panic("Code Gen Error: @bswap needs a whole number of byte pairs, got %.*s", value.type->name.length, value.type->name.data);
+    }
+
+    LLVMTypeRef overload = value.type->llvm_type;
+    return (Value){ codegen_intrinsic_call(context, "llvm.bswap", &overload, 1, &value.llvm_value, 1), value.type };
+}
+
+// @clz and @ctz of zero are the bit width, as on most hardware
+static Value builtin_count_zeros(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value value = builtin_integer_argument(context, fn_call, 1, 0, expected);
+    const char* intrinsic = string_compare_literal(builtin_name(fn_call), "@clz") ? "llvm.ctlz" : "llvm.cttz";
+
+    LLVMTypeRef overload = value.type->llvm_type;
+    LLVMValueRef arguments[] = { value.llvm_value, LLVMConstInt(LLVMInt1Type(), 0, 0) };
+    return (Value){ codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 2), value.type };
+}
+
+// @rotl(x, n) and @rotr(x, n) are funnel shifts of x with itself
+static Value builtin_rotate(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value value = builtin_integer_argument(context, fn_call, 2, 0, expected);
+    Value amount = builtin_integer_argument(context, fn_call, 2, 1, value.type);
+
+    // the amount is taken modulo the width, so any integer type will do
+    Type* element = type_element(value.type);
+    LLVMValueRef shift = amount.llvm_value;
+    if (type_element(amount.type) != element) {
+        Type* cast_type = amount.type->kind == TypeKind_Vector ? type_vector(context, element, amount.type->lanes) : element;
+        shift = LLVMBuildIntCast2(context->builder, shift, cast_type->llvm_type, 0, "");
+    }
+    if (value.type->kind == TypeKind_Vector && amount.type->kind != TypeKind_Vector) {
+        shift = codegen_splat(context, shift, value.type);
+    }
+
+    const char* intrinsic = string_compare_literal(builtin_name(fn_call), "@rotl") ? "llvm.fshl" : "llvm.fshr";
+    LLVMTypeRef overload = value.type->llvm_type;
+    LLVMValueRef arguments[] = { value.llvm_value, value.llvm_value, shift };
+    return (Value){ codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 3), value.type };
+}
+
+// @prefetch(p) or @prefetch(p, write, locality), with locality 0 (none) to
+// 3 (keep in all caches)
+static Value builtin_prefetch(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    List* arguments = &fn_call->data.primary_expression.function_call.parameters;
+    size_t count = arguments->length == 1 ? 1 : 3;
+
+    unsigned int alignment;
+    Value pointer = builtin_pointer_argument(context, fn_call, count, 0);
+    LLVMValueRef address = byte_pointer(context, pointer, &alignment);
+
+    Type* int_type = type_int(context, 32, 1);
+    LLVMValueRef write = LLVMConstInt(int_type->llvm_type, 0, 0);
+    LLVMValueRef locality = LLVMConstInt(int_type->llvm_type, 3, 0);
+    if (count == 3) {
+        write = builtin_constant_argument(context, fn_call, count, 1, int_type);
+        locality = builtin_constant_argument(context, fn_call, count, 2, int_type);
+        if (LLVMConstIntGetZExtValue(write) > 1 || LLVMConstIntGetZExtValue(locality) > 3) {
+            sil_panic("Code Gen Error: @prefetch takes write 0 or 1 and locality 0 to 3");
+        }
+    }
+
+    LLVMTypeRef overload = LLVMTypeOf(address);
+    LLVMValueRef prefetch_arguments[] = {
+        address,
+        write,
+        locality,
+        // data, not instruction, cache
+        LLVMConstInt(int_type->llvm_type, 1, 0),
+    };
+    codegen_intrinsic_call(context, "llvm.prefetch", &overload, 1, prefetch_arguments, 4);
+    return builtin_void(context);
+}
+
+// A constant length is expanded in place and never becomes a call to the C
+// library.
+static Value builtin_memcpy(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    unsigned int destination_alignment;
+    unsigned int source_alignment;
+    Value destination = builtin_pointer_argument(context, fn_call, 3, 0);
+    Value source = builtin_pointer_argument(context, fn_call, 3, 1);
+    LLVMValueRef destination_bytes = byte_pointer(context, destination, &destination_alignment);
+    LLVMValueRef source_bytes = byte_pointer(context, source, &source_alignment);
+    codegen_check_pure_store(context, destination_bytes);
+
+    Type* size_type = type_int(context, LLVMPointerSize(LLVMGetModuleDataLayout(context->module)) * 8, 0);
+    Value length = codegen_expression(context, builtin_argument(fn_call, 3, 2), size_type);
+    length = codegen_coerce(context, length, size_type);
+
+    if (!LLVMIsAConstantInt(length.llvm_value)) {
+        LLVMBuildMemCpy(context->builder, destination_bytes, destination_alignment, source_bytes, source_alignment, length.llvm_value);
+        return builtin_void(context);
+    }
+
+    LLVMTypeRef overloads[] = { LLVMTypeOf(destination_bytes), LLVMTypeOf(source_bytes), size_type->llvm_type };
+    LLVMValueRef arguments[] = { destination_bytes, source_bytes, length.llvm_value, LLVMConstInt(LLVMInt1Type(), 0, 0) };
+    LLVMValueRef call = codegen_intrinsic_call(context, "llvm.memcpy.inline", overloads, 3, arguments, 4);
+    set_argument_alignment(call, 0, destination_alignment);
+    set_argument_alignment(call, 1, source_alignment);
+    return builtin_void(context);
+}
+
+static Value builtin_memset(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    unsigned int alignment;
+    Value destination = builtin_pointer_argument(context, fn_call, 3, 0);
+    LLVMValueRef destination_bytes = byte_pointer(context, destination, &alignment);
+    codegen_check_pure_store(context, destination_bytes);
+
+    Type* byte_type = type_int(context, 8, 0);
+    Value byte = codegen_expression(context, builtin_argument(fn_call, 3, 1), byte_type);
+    byte = codegen_coerce(context, byte, byte_type);
+
+    Type* size_type = type_int(context, LLVMPointerSize(LLVMGetModuleDataLayout(context->module)) * 8, 0);
+    Value length = codegen_expression(context, builtin_argument(fn_call, 3, 2), size_type);
+    length = codegen_coerce(context, length, size_type);
+
+    if (!LLVMIsAConstantInt(length.llvm_value)) {
+        LLVMBuildMemSet(context->builder, destination_bytes, byte.llvm_value, length.llvm_value, alignment);
+        return builtin_void(context);
+    }
+
+    // there is no llvm.memset.inline yet, but one store of a splatted byte
+    // vector is always split up in place. Past a few registers' worth that
+    // is one store per lane, so longer runs are left to llvm.memset.
+    uint64_t count = LLVMConstIntGetZExtValue(length.llvm_value);
+    if (count == 0) {
+        return builtin_void(context);
+    }
+    if (count > BUILTIN_MEMSET_INLINE_BYTES) {
+        LLVMBuildMemSet(context->builder, destination_bytes, byte.llvm_value, length.llvm_value, alignment);
+        return builtin_void(context);
+    }
+    Type* bytes_type = type_vector(context, byte_type, count);
+    LLVMValueRef bytes = codegen_splat(context, byte.llvm_value, bytes_type);
+    LLVMValueRef address = LLVMBuildPointerCast(context->builder, destination_bytes, LLVMPointerType(bytes_type->llvm_type, 0), "");
+    LLVMValueRef store = LLVMBuildStore(context->builder, bytes, address);
+    LLVMSetAlignment(store, alignment);
+    return builtin_void(context);
+}
+
+// @nontemporal_store(p, value) writes around the cache, for output that
+// will not be read again soon
+static Value builtin_nontemporal_store(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    Value pointer = builtin_pointer_argument(context, fn_call, 2, 0);
+    Type* pointee = pointer.type->child;
+    if (pointee->kind == TypeKind_Void) {
+        sil_panic("Code Gen Error: @nontemporal_store cannot store through *void");
+    }
+    codegen_check_pure_store(context, pointer.llvm_value);
+
+    Value value = codegen_expression(context, builtin_argument(fn_call, 2, 1), pointee);
+    value = codegen_coerce(context, value, pointee);
+
+    LLVMValueRef store = LLVMBuildStore(context->builder, value.llvm_value, pointer.llvm_value);
+    LLVMContextRef llvm_context = LLVMGetGlobalContext();
+    LLVMMetadataRef one = LLVMValueAsMetadata(LLVMConstInt(LLVMInt32Type(), 1, 0));
+    LLVMMetadataRef node = LLVMMDNodeInContext2(llvm_context, &one, 1);
+    LLVMSetMetadata(store, LLVMGetMDKindID("nontemporal", strlen("nontemporal")), LLVMMetadataAsValue(llvm_context, node));
+
+    return builtin_void(context);
+}
+
+// @float_mode(optimized) or @float_mode(strict) sets the floating point
+// semantics for the rest of the enclosing block
+static Value builtin_float_mode(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    AstNode* mode = builtin_argument(fn_call, 1, 0);
+    String name = mode->type == AstNodeType_PrimaryExpression && mode->data.primary_expression.type == PrimaryExpressionType_Variable
+        ? mode->data.primary_expression.variable.name
+        : (String){ "", 0 };
+
+    if (string_compare_literal(name, "optimized") && name.length == strlen("optimized")) {
+        context->float_mode = FloatMode_Optimized;
+    } else if (string_compare_literal(name, "strict") && name.length == strlen("strict")) {
+        context->float_mode = FloatMode_Strict;
+    } else {
+        sil_panic("Code Gen Error: @float_mode takes optimized or strict");
+    }
+
+    return builtin_void(context);
+}
+
+// @splat(x) fills a vector whose type comes from the context
+static Value builtin_splat(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    if (expected == NULL || expected->kind != TypeKind_Vector) {
+        sil_panic("Code Gen Error: @splat needs a vector type from its context");
+    }
+    Value scalar = codegen_expression(context, builtin_argument(fn_call, 1, 0), expected->child);
+    scalar = codegen_coerce(context, scalar, expected->child);
+    return (Value){ codegen_splat(context, scalar.llvm_value, expected), expected };
+}
+
+// @shuffle(a, b, lanes...) picks each result lane from a (0..n-1) or b
+// (n..2n-1); the lane indices must be constants.
+static Value builtin_shuffle(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    List* arguments = &fn_call->data.primary_expression.function_call.parameters;
+    if (arguments->length < 3) {
+        sil_panic("Code Gen Error: @shuffle takes two vectors and at least one lane");
+    }
+    size_t count = arguments->length;
+
+    Value a = builtin_vector_argument(context, fn_call, count, 0, NULL);
+    Value b = builtin_vector_argument(context, fn_call, count, 1, a.type);
+    if (a.type != b.type) {
+        sil_panic("Code Gen Error: @shuffle vectors differ: %.*s and %.*s", a.type->name.length, a.type->name.data, b.type->name.length, b.type->name.data);
+    }
+
+    unsigned int lanes = count - 2;
+    LLVMValueRef* mask = malloc(sizeof(LLVMValueRef) * lanes);
+    Type* index_type = type_int(context, 32, 0);
+    for (unsigned int i = 0; i < lanes; i++) {
+        AstNode* lane_node = *list_get(AstNode*, arguments, i + 2);
+        Value lane = codegen_expression(context, lane_node, index_type);
+        if (!LLVMIsAConstantInt(lane.llvm_value) || LLVMConstIntGetZExtValue(lane.llvm_value) >= a.type->lanes * 2) {
+            sil_panic("Code Gen Error: @shuffle lanes must be constants below %u", a.type->lanes * 2);
+        }
+        mask[i] = lane.llvm_value;
+    }
+
+    LLVMValueRef mask_vector = LLVMConstVector(mask, lanes);
+    free(mask);
+
+    Type* type = type_vector(context, a.type->child, lanes);
+    return (Value){ LLVMBuildShuffleVector(context->builder, a.llvm_value, b.llvm_value, mask_vector, ""), type };
+}
+
+// @select(mask, a, b) takes each lane from a where the mask is true
+static Value builtin_select(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value mask = builtin_vector_argument(context, fn_call, 3, 0, NULL);
+    if (mask.type->child->kind != TypeKind_Bool) {
+        sil_panic("Code Gen Error: @select mask must have bool lanes, got %.*s", mask.type->name.length, mask.type->name.data);
+    }
+
+    Value a = codegen_expression(context, builtin_argument(fn_call, 3, 1), expected);
+    Value b = codegen_expression(context, builtin_argument(fn_call, 3, 2), a.type);
+    Type* type = type_coerces_to(a.type, b.type) ? b.type : a.type;
+    if (type->kind != TypeKind_Vector) {
+        type = type_vector(context, type, mask.type->lanes);
+    }
+    if (type->lanes != mask.type->lanes) {
+        sil_panic("Code Gen Error: @select mask has %u lanes, values have %u", mask.type->lanes, type->lanes);
+    }
+    a = codegen_coerce(context, a, type);
+    b = codegen_coerce(context, b, type);
+    return (Value){ LLVMBuildSelect(context->builder, mask.llvm_value, a.llvm_value, b.llvm_value, ""), type };
+}
+
+static Value builtin_extract(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    Value vector = builtin_vector_argument(context, fn_call, 2, 0, NULL);
+    Value index = builtin_integer_argument(context, fn_call, 2, 1, type_int(context, 32, 0));
+    return (Value){ LLVMBuildExtractElement(context->builder, vector.llvm_value, index.llvm_value, ""), vector.type->child };
+}
+
+static Value builtin_insert(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    Value vector = builtin_vector_argument(context, fn_call, 3, 0, expected);
+    Value index = builtin_integer_argument(context, fn_call, 3, 1, type_int(context, 32, 0));
+    Value lane = codegen_expression(context, builtin_argument(fn_call, 3, 2), vector.type->child);
+    lane = codegen_coerce(context, lane, vector.type->child);
+
+    LLVMValueRef result = LLVMBuildInsertElement(context->builder, vector.llvm_value, lane.llvm_value, index.llvm_value, "");
+    return (Value){ result, vector.type };
+}
+
+// @reduce_add(v) and friends fold the lanes of a vector into one value.
+static Value builtin_vector_reduce(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    (void)expected;
+    String name = builtin_name(fn_call);
+    Value vector = builtin_vector_argument(context, fn_call, 1, 0, NULL);
+    Type* element = vector.type->child;
+    String operation = { name.data + strlen("@reduce_"), name.length - strlen("@reduce_") };
+    int is_float = element->kind == TypeKind_Float;
+    int is_arithmetic = string_compare_literal(operation, "add") || string_compare_literal(operation, "mul");
+
+    char intrinsic[64];
+    if (string_compare_literal(operation, "min") || string_compare_literal(operation, "max")) {
+        if (element->kind == TypeKind_Bool) {
+            sil_panic("Code Gen Error: %.*s is not defined for bool lanes", name.length, name.data);
+        }
+        char prefix = is_float ? 'f' : element->is_signed ? 's' : 'u';
+        snprintf(intrinsic, sizeof(intrinsic), "llvm.vector.reduce.%c%.*s", prefix, operation.length, operation.data);
+    } else if (is_arithmetic) {
+        snprintf(intrinsic, sizeof(intrinsic), "llvm.vector.reduce.%s%.*s", is_float ? "f" : "", operation.length, operation.data);
+    } else {
+        if (is_float) {
+            sil_panic("Code Gen Error: %.*s is not defined for float lanes", name.length, name.data);
+        }
+        snprintf(intrinsic, sizeof(intrinsic), "llvm.vector.reduce.%.*s", operation.length, operation.data);
+    }
+
+    LLVMTypeRef overload = vector.type->llvm_type;
+    LLVMValueRef result;
+    if (is_float && is_arithmetic) {
+        // strict float reductions run in lane order from the identity; in
+        // an optimized float mode they may become a tree
+        LLVMValueRef start = string_compare_literal(operation, "add")
+            ? LLVMConstReal(element->llvm_type, -0.0)
+            : LLVMConstReal(element->llvm_type, 1.0);
+        LLVMValueRef arguments[] = { start, vector.llvm_value };
+        result = codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 2);
+    } else {
+        result = codegen_intrinsic_call(context, intrinsic, &overload, 1, &vector.llvm_value, 1);
+    }
+
+    if (is_float) {
+        codegen_float_flags(context, result);
+    }
+    return (Value){ result, element };
+}
+
+// expected is only a hint; lowerings with a fixed result type ignore it
+typedef Value (*BuiltinLowering)(CodegenContext* context, AstNode* fn_call, Type* expected);
+
+static const struct {
+    char* name;
+    BuiltinLowering lower;
+} builtins[] = {
+    { "@likely", builtin_branch_expect },
+    { "@unlikely", builtin_branch_expect },
+    { "@expect", builtin_expect },
+    { "@assume", builtin_assume },
+    { "@popcount", builtin_popcount },
+    { "@clz", builtin_count_zeros },
+    { "@ctz", builtin_count_zeros },
+    { "@bswap", builtin_bswap },
+    { "@rotl", builtin_rotate },
+    { "@rotr", builtin_rotate },
+    { "@prefetch", builtin_prefetch },
+    { "@memcpy", builtin_memcpy },
+    { "@memset", builtin_memset },
+    { "@nontemporal_store", builtin_nontemporal_store },
+    { "@float_mode", builtin_float_mode },
+    { "@splat", builtin_splat },
+    { "@shuffle", builtin_shuffle },
+    { "@select", builtin_select },
+    { "@extract", builtin_extract },
+    { "@insert", builtin_insert },
+    { "@reduce_add", builtin_vector_reduce },
+    { "@reduce_mul", builtin_vector_reduce },
+    { "@reduce_and", builtin_vector_reduce },
+    { "@reduce_or", builtin_vector_reduce },
+    { "@reduce_xor", builtin_vector_reduce },
+    { "@reduce_min", builtin_vector_reduce },
+    { "@reduce_max", builtin_vector_reduce },
+};
+
+Value builtin_call(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    String name = builtin_name(fn_call);
+    for (size_t i = 0; i < sizeof(builtins) / sizeof(builtins[0]); i++) {
+        if ((size_t)name.length == strlen(builtins[i].name) && string_compare_literal(name, builtins[i].name)) {
+            return builtins[i].lower(context, fn_call, expected);
+        }
+    }
+
+    sil_panic("Code Gen Error: Unknown builtin %.*s", name.length, name.data);
+}
@@ -0,0 +1,22 @@
+#ifndef CODEGEN_BUILTIN_H
+#define CODEGEN_BUILTIN_H
+
+#include "codegen/type.h"
+#include "parser/parser.h"
+
+typedef struct CodegenContext CodegenContext;
+
+typedef enum BranchHint {
+    BranchHint_None,
+    BranchHint_Likely,
+    BranchHint_Unlikely,
+} BranchHint;
+
+// The hint of an @likely(x) or @unlikely(x) call, otherwise none.
+BranchHint builtin_branch_hint(AstNode* expression);
+
+// Lowers an @name call straight to LLVM instructions or intrinsics, so
+// builtins cost no call and need no runtime library.
+Value builtin_call(CodegenContext* context, AstNode* fn_call, Type* expected);
+
+#endif
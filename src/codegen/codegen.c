@@ -1,6 +1,15 @@
 #include "codegen.h"
 
 #include "codegen/analyze.h"
+#include "codegen/backend.h"
+#include "codegen/builtin.h"
+#include "codegen/instrument.h"
+#include "codegen/ir_patch.h"
+#include "codegen/layout.h"
+#include "codegen/mca.h"
+#include "codegen/size_report.h"
+#include "codegen/stack_usage.h"
+#include "codegen/wcet.h"
 #include "list.h"
 #include "parser/expression.h"
 #include "parser/parser.h"
@@ -8,170 +17,2315 @@
 #include "util.h"
 
 #include "llvm-c/Core.h"
+#include "llvm-c/DebugInfo.h"
 #include "llvm-c/Types.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 
-static LLVMTypeRef to_llvm_type(AstNode* type_name) {
-    if (type_name->data.type_name.type == AstNodeTypeNameType_Pointer) {
-        return LLVMPointerType(to_llvm_type(type_name->data.type_name.child_type), 0);
+void codegen_add_fn_attribute(LLVMValueRef function, const char* name) {
+    unsigned int kind = LLVMGetEnumAttributeKindForName(name, strlen(name));
+    LLVMAttributeRef attribute = LLVMCreateEnumAttribute(LLVMGetGlobalContext(), kind, 0);
+    LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex, attribute);
+}
+
+LLVMValueRef codegen_intrinsic_call(
+    CodegenContext* context,
+    const char* name,
+    LLVMTypeRef* overloads,
+    size_t overload_count,
+    LLVMValueRef* arguments,
+    unsigned int argument_count
+) {
+    unsigned int id = LLVMLookupIntrinsicID(name, strlen(name));
+    if (id == 0) {
+        sil_panic("Code Gen Error: Unknown intrinsic %s", name);
+    }
+
+    LLVMValueRef intrinsic = LLVMGetIntrinsicDeclaration(context->module, id, overloads, overload_count);
+    LLVMTypeRef type = LLVMIntrinsicGetType(LLVMGetGlobalContext(), id, overloads, overload_count);
+    return LLVMBuildCall2(context->builder, type, intrinsic, arguments, argument_count, "");
+}
+
+void codegen_float_flags(CodegenContext* context, LLVMValueRef instruction) {
+    if (context->float_mode == FloatMode_Optimized && LLVMIsAInstruction(instruction)) {
+        ir_patch_mark(context, instruction, IrPatch_FastMath);
+    }
+}
+
+// every lane of the vector set to the scalar
+LLVMValueRef codegen_splat(CodegenContext* context, LLVMValueRef scalar, Type* vector) {
+    if (LLVMIsConstant(scalar)) {
+        LLVMValueRef* lanes = malloc(sizeof(LLVMValueRef) * vector->lanes);
+        for (unsigned int i = 0; i < vector->lanes; i++) {
+            lanes[i] = scalar;
+        }
+        LLVMValueRef splat = LLVMConstVector(lanes, vector->lanes);
+        free(lanes);
+        return splat;
+    }
+
+    // insert into lane 0, then broadcast it with an all-zero shuffle mask
+    LLVMValueRef zero = LLVMConstInt(LLVMInt32Type(), 0, 0);
+    LLVMValueRef single = LLVMBuildInsertElement(context->builder, LLVMGetUndef(vector->llvm_type), scalar, zero, "");
+    LLVMValueRef mask = LLVMConstNull(LLVMVectorType(LLVMInt32Type(), vector->lanes));
+    return LLVMBuildShuffleVector(context->builder, single, LLVMGetUndef(vector->llvm_type), mask, "");
+}
+
+// widens a value to the type the surrounding code needs
+Value codegen_coerce(CodegenContext* context, Value value, Type* type) {
+    if (value.type == type) {
+        return value;
+    }
+
+    if (!type_coerces_to(value.type, type)) {
+        sil_panic(
+            "Code Gen Error: Expected %.*s, got %.*s",
+            type->name.length,
+            type->name.data,
+            value.type->name.length,
+            value.type->name.data
+        );
+    }
+
+    if (type->kind == TypeKind_Slice) {
+        return (Value){ value.llvm_value, type };
+    }
+
+    if (type->kind == TypeKind_Vector && value.type->kind != TypeKind_Vector) {
+        value = codegen_coerce(context, value, type->child);
+        return (Value){ codegen_splat(context, value.llvm_value, type), type };
+    }
+
+    LLVMValueRef llvm_value;
+    if (type_element(type)->kind == TypeKind_Float) {
+        llvm_value = LLVMBuildFPExt(context->builder, value.llvm_value, type->llvm_type, "");
+    } else if (value.type->is_signed) {
+        llvm_value = LLVMBuildSExt(context->builder, value.llvm_value, type->llvm_type, "");
+    } else {
+        llvm_value = LLVMBuildZExt(context->builder, value.llvm_value, type->llvm_type, "");
+    }
+
+    return (Value){ llvm_value, type };
+}
+
+// Allocas in the entry block are the ones mem2reg and SROA promote.
+static LLVMValueRef codegen_entry_alloca(CodegenContext* context, Type* type, String name) {
+    LLVMBasicBlockRef entry = LLVMGetEntryBasicBlock(context->current_function);
+    LLVMValueRef first_instruction = LLVMGetFirstInstruction(entry);
+
+    LLVMBuilderRef builder = LLVMCreateBuilder();
+    if (first_instruction != NULL) {
+        LLVMPositionBuilderBefore(builder, first_instruction);
+    } else {
+        LLVMPositionBuilderAtEnd(builder, entry);
+    }
+
+    LLVMValueRef slot = LLVMBuildAlloca(builder, type->llvm_type, name.data);
+    LLVMSetAlignment(slot, type_align(context, type));
+    LLVMDisposeBuilder(builder);
+
+    return slot;
+}
+
+// Where a value lives: in memory at pointer, or as the SSA value when
+// pointer is NULL.
+typedef struct Place {
+    Type* type;
+    LLVMValueRef pointer;
+    unsigned int align;
+    LLVMValueRef value;
+    // an element of a @soa array, whose fields are spread over the columns
+    // of the array at pointer
+    Type* soa;
+    LLVMValueRef soa_index;
+    int is_mutable;
+} Place;
+
+static Place place_in_memory(Type* type, LLVMValueRef pointer, unsigned int align, int is_mutable) {
+    return (Place){ type, pointer, align, NULL, NULL, NULL, is_mutable };
+}
+
+static Place place_of_value(Value value) {
+    return (Place){ value.type, NULL, 0, value.llvm_value, NULL, NULL, 0 };
+}
+
+// Memory accesses carry the alignment sil laid the type out with, which
+// LLVM cannot derive from a packed struct.
+static LLVMValueRef codegen_load(CodegenContext* context, Type* type, LLVMValueRef pointer, unsigned int align) {
+    LLVMValueRef load = LLVMBuildLoad2(context->builder, type->llvm_type, pointer, "");
+    LLVMSetAlignment(load, align);
+    return load;
+}
+
+static void codegen_store(CodegenContext* context, LLVMValueRef value, LLVMValueRef pointer, unsigned int align) {
+    LLVMValueRef store = LLVMBuildStore(context->builder, value, pointer);
+    LLVMSetAlignment(store, align);
+}
+
+static void codegen_add_local(CodegenContext* context, String name, unsigned int symbol, Value value, int is_mutable, int in_memory) {
+    if (value.type->kind == TypeKind_Void || value.type->kind == TypeKind_Never) {
+        sil_panic("Code Gen Error: %.*s cannot hold a %.*s value", name.length, name.data, value.type->name.length, value.type->name.data);
+    }
+
+    Local* local = scope_bind(&context->symbols, symbol, name);
+    local->value = value;
+    local->is_mutable = is_mutable;
+    local->in_memory = in_memory;
+}
+
+// The alloca an address into this function's frame was computed from, or
+// NULL for memory the function does not own.
+static LLVMValueRef codegen_frame_alloca(LLVMValueRef pointer) {
+    while (LLVMIsAGetElementPtrInst(pointer) != NULL || LLVMIsACastInst(pointer) != NULL) {
+        pointer = LLVMGetOperand(pointer, 0);
+    }
+    return LLVMIsAAllocaInst(pointer);
+}
+
+// pure lets the optimizer delete and hoist calls, so the body may neither
+// write memory it does not own nor run forever
+static void codegen_check_pure(CodegenContext* context, const char* what) {
+    AstNodeFnProto* fn_proto = &context->current_fn_proto->data.fn_proto;
+    if (fn_proto->attributes & FnAttribute_Pure) {
+        sil_panic("Code Gen Error: Pure function %.*s %s", fn_proto->name.length, fn_proto->name.data, what);
+    }
+}
+
+void codegen_check_pure_store(CodegenContext* context, LLVMValueRef pointer) {
+    if (codegen_frame_alloca(pointer) == NULL) {
+        codegen_check_pure(context, "stores through a pointer");
+    }
+}
+
+// Copied out, since generating more code can grow the binding array.
+static Local codegen_find_local(CodegenContext* context, String name, unsigned int symbol) {
+    Local* local = scope_find(&context->symbols, symbol);
+    if (local == NULL) {
+        sil_panic("Code Gen Error: Unknown variable %.*s", name.length, name.data);
+    }
+
+    return *local;
+}
+
+static Value codegen_fn_call(CodegenContext* context, AstNode* fn_call, Type* expected) {
+    String name = fn_call->data.primary_expression.function_call.name;
+    if (name.data[0] == '@') {
+        return builtin_call(context, fn_call, expected);
+    }
+
+    AstNode* fn = map_get(&context->function_map, name);
+    if (fn == NULL) {
+        sil_panic("Function not defined %.*s", name.length, name.data);
+    }
+
+    stack_usage_add_call(context, name);
+
+    LLVMValueRef fn_ref = LLVMGetNamedFunction(context->module, name.data);
+    AstNode* fn_proto = fn->data.fn.prototype;
+    int caller_attributes = context->current_fn_proto->data.fn_proto.attributes;
+    int callee_attributes = fn_proto->data.fn_proto.attributes;
+
+    // the optimizer trusts pure, so it has to hold all the way down; an
+    // extern body is never checked
+    if ((caller_attributes & FnAttribute_Pure) && fn->type == AstNodeType_ExternFn) {
+        String caller = context->current_fn_proto->data.fn_proto.name;
+        sil_panic(
+            "Code Gen Error: Pure function %.*s calls extern %.*s",
+            caller.length,
+            caller.data,
+            name.length,
+            name.data
+        );
+    }
+    if ((caller_attributes & FnAttribute_Pure) && !(callee_attributes & FnAttribute_Pure)) {
+        String caller = context->current_fn_proto->data.fn_proto.name;
+        sil_panic(
+            "Code Gen Error: Pure function %.*s calls %.*s, which is not pure",
+            caller.length,
+            caller.data,
+            name.length,
+            name.data
+        );
+    }
+    List* fn_parameters = &fn_proto->data.fn_proto.parameters;
+
+    List* parameter_list = &fn_call->data.primary_expression.function_call.parameters;
+    int param_count = fn_call->data.primary_expression.function_call.parameters.length;
+    if (param_count != fn_parameters->length) {
+        sil_panic("Wrong number of arguments");
+    }
+
+    LLVMValueRef* parameters = malloc(sizeof(LLVMValueRef) * param_count);
+    for (int i = 0; i < param_count; i++) {
+        AstNode* pattern = *list_get(AstNode*, fn_parameters, i);
+        Type* type = type_from_ast(context, pattern->data.pattern.type);
+        // a string literal passes as its pointer, any other slice needs .ptr
+        Value argument = codegen_expression(context, *list_get(AstNode*, parameter_list, i), type);
+        parameters[i] = codegen_coerce(context, argument, type).llvm_value;
+    }
+
+
+    LLVMValueRef call_ref = LLVMBuildCall2(
+        context->builder,
+        fn_proto->data.fn_proto.llvm_fn_type,
+        fn_ref,
+        parameters,
+        param_count,
+        ""
+    );
+
+    free(parameters);
+
+    // flatten inlines one level, like the call sites had always_inline
+    if ((caller_attributes & FnAttribute_Flatten) && fn->type == AstNodeType_Fn
+        && !(callee_attributes & FnAttribute_NoInline)) {
+        unsigned int kind = LLVMGetEnumAttributeKindForName("alwaysinline", strlen("alwaysinline"));
+        LLVMAttributeRef attribute = LLVMCreateEnumAttribute(LLVMGetGlobalContext(), kind, 0);
+        LLVMAddCallSiteAttribute(call_ref, LLVMAttributeFunctionIndex, attribute);
+    }
+
+    // nothing after a call that never returns can run, which ends the block
+    // like a return does
+    Type* return_type = type_from_ast(context, fn_proto->data.fn_proto.return_type);
+    if (return_type->kind == TypeKind_Never) {
+        LLVMBuildUnreachable(context->builder);
+    }
+
+    return (Value){ call_ref, return_type };
+}
+
+// Literals have no type of their own and take the one the context expects,
+// defaulting to i32 and f64. A leading minus is folded in so the range
+// check sees the value actually stored.
+static Value codegen_number(CodegenContext* context, String text, Type* expected, int negative) {
+    // a literal where a vector is expected fills every lane
+    if (expected != NULL && expected->kind == TypeKind_Vector) {
+        Value lane = codegen_number(context, text, expected->child, negative);
+        return (Value){ codegen_splat(context, lane.llvm_value, expected), expected };
+    }
+
+    int is_float = memchr(text.data, '.', text.length) != NULL;
+
+    Type* type = expected;
+    if (type == NULL) {
+        type = is_float ? type_float(context, 64) : type_int(context, 32, 1);
+    }
+
+    if (type->kind == TypeKind_Float) {
+        LLVMValueRef real = LLVMConstRealOfStringAndSize(type->llvm_type, text.data, text.length);
+        return (Value){ negative ? LLVMConstFNeg(real) : real, type };
+    }
+
+    if (is_float || type->kind != TypeKind_Int) {
+        sil_panic(
+            "Code Gen Error: Number literal %.*s cannot be %.*s",
+            text.length,
+            text.data,
+            type->name.length,
+            type->name.data
+        );
+    }
+
+    // largest magnitude: 2^bits - 1 unsigned, 2^(bits-1) - 1 or 2^(bits-1) signed
+    unsigned int magnitude_bits = type->is_signed ? type->bits - 1 : type->bits;
+    unsigned long long limit = magnitude_bits == 64 ? ~0ull : (1ull << magnitude_bits) - 1;
+    if (negative && type->is_signed) {
+        limit += 1;
+    }
+
+    unsigned long long value;
+    int fits = string_to_integer(text, &value) && value <= limit;
+    if (!fits || (negative && !type->is_signed && value != 0)) {
+        sil_panic(
+            "Code Gen Error: Number literal %s%.*s does not fit in %.*s",
+            negative ? "-" : "",
+            text.length,
+            text.data,
+            type->name.length,
+            type->name.data
+        );
+    }
+
+    return (Value){ LLVMConstInt(type->llvm_type, negative ? -value : value, 0), type };
+}
+
+// A []const u8 of the text. A NUL follows the text in memory, so where
+// a *u8 is expected the literal passes just its pointer.
+static Value codegen_string_literal(CodegenContext* context, String text, Type* expected) {
+    LLVMValueRef initializer = LLVMConstString(text.data, text.length, 0);
+    LLVMValueRef global = LLVMAddGlobal(context->module, LLVMTypeOf(initializer), ".str");
+    LLVMSetInitializer(global, initializer);
+    LLVMSetGlobalConstant(global, 1);
+    LLVMSetLinkage(global, LLVMPrivateLinkage);
+    LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+    LLVMSetAlignment(global, 1);
+
+    Type* byte = type_int(context, 8, 0);
+    Type* pointer_type = type_pointer(context, byte);
+    LLVMValueRef pointer = LLVMConstPointerCast(global, pointer_type->llvm_type);
+    if (expected != NULL && expected == pointer_type) {
+        return (Value){ pointer, pointer_type };
+    }
+
+    Type* type = type_slice(context, byte, 1);
+    LLVMValueRef elements[] = { pointer, LLVMConstInt(type_usize(context)->llvm_type, text.length, 0) };
+    return (Value){ LLVMConstStruct(elements, 2, 0), type };
+}
+
+static Value codegen_primary_expression(CodegenContext* context, AstNode* primary, Type* expected) {
+    switch (primary->data.primary_expression.type) {
+        case PrimaryExpressionType_Number:
+            return codegen_number(context, primary->data.primary_expression.number, expected, 0);
+        case PrimaryExpressionType_String:
+            return codegen_string_literal(context, primary->data.primary_expression.string, expected);
+
+        case PrimaryExpressionType_Bool:
+            return (Value){ LLVMConstInt(LLVMInt1Type(), primary->data.primary_expression.boolean, 0), type_bool(context) };
+        case PrimaryExpressionType_Symbol:
+            return codegen_fn_call(context, primary, expected);
+        case PrimaryExpressionType_Variable: {
+            PrimaryExpressionVariable* variable = &primary->data.primary_expression.variable;
+            Local local = codegen_find_local(context, variable->name, variable->symbol);
+            if (!local.in_memory) {
+                return local.value;
+            }
+
+            Type* type = local.value.type;
+            LLVMValueRef value = codegen_load(context, type, local.value.llvm_value, type_align(context, type));
+            return (Value){ value, type };
+        }
+        default:
+            sil_panic("Code Gen Error: Unhandled primary expression");
+    }
+}
+
+static int is_number_literal(AstNode* expression) {
+    if (expression->type == AstNodeType_UnaryOperator) {
+        return is_number_literal(expression->data.unary_operator.value);
+    }
+    return expression->type == AstNodeType_PrimaryExpression
+        && expression->data.primary_expression.type == PrimaryExpressionType_Number;
+}
+
+static const char* binary_operator_string(BinaryOperatorType type) {
+    switch (type) {
+        case BinaryOperatorType_Addition: return "+";
+        case BinaryOperatorType_Subtraction: return "-";
+        case BinaryOperatorType_Multiplication: return "*";
+        case BinaryOperatorType_Division: return "/";
+        case BinaryOperatorType_Remainder: return "%";
+        case BinaryOperatorType_ShiftLeft: return "<<";
+        case BinaryOperatorType_ShiftRight: return ">>";
+        case BinaryOperatorType_BitwiseAnd: return "&";
+        case BinaryOperatorType_BitwiseOr: return "|";
+        case BinaryOperatorType_BitwiseXor: return "^";
+        case BinaryOperatorType_WrappingAddition: return "+%";
+        case BinaryOperatorType_WrappingSubtraction: return "-%";
+        case BinaryOperatorType_WrappingMultiplication: return "*%";
+        case BinaryOperatorType_SaturatingAddition: return "+|";
+        case BinaryOperatorType_SaturatingSubtraction: return "-|";
+        case BinaryOperatorType_SaturatingMultiplication: return "*|";
+        case BinaryOperatorType_Equal: return "==";
+        case BinaryOperatorType_NotEqual: return "!=";
+        case BinaryOperatorType_Less: return "<";
+        case BinaryOperatorType_LessEqual: return "<=";
+        case BinaryOperatorType_Greater: return ">";
+        case BinaryOperatorType_GreaterEqual: return ">=";
+        default: return "?";
+    }
+}
+
+// The text of a slice made from a string literal.
+static int codegen_constant_text(LLVMValueRef slice, String* text) {
+    if (!LLVMIsAConstantStruct(slice)) {
+        return 0;
+    }
+
+    LLVMValueRef pointer = LLVMGetOperand(slice, 0);
+    LLVMValueRef global = LLVMIsAConstantExpr(pointer) ? LLVMGetOperand(pointer, 0) : pointer;
+    if (!LLVMIsAGlobalVariable(global) || !LLVMIsGlobalConstant(global)) {
+        return 0;
+    }
+
+    LLVMValueRef initializer = LLVMGetInitializer(global);
+    if (initializer == NULL || !LLVMIsAConstantDataSequential(initializer) || !LLVMIsConstantString(initializer)) {
+        return 0;
+    }
+
+    size_t length;
+    text->data = (char*)LLVMGetAsString(initializer, &length);
+    text->length = LLVMConstIntGetZExtValue(LLVMGetOperand(slice, 1));
+    return 1;
+}
+
+// Slices are equal when their lengths are and then every element is, so
+// slices of different lengths are never scanned and two literals compare
+// at compile time.
+static LLVMValueRef codegen_slice_equal(CodegenContext* context, Value left, Value right) {
+    Type* element = left.type->child;
+    if (element->kind != TypeKind_Int && element->kind != TypeKind_Bool) {
+        sil_panic("Code Gen Error: Operator == not defined for %.*s", left.type->name.length, left.type->name.data);
+    }
+
+    String left_text, right_text;
+    if (codegen_constant_text(left.llvm_value, &left_text) && codegen_constant_text(right.llvm_value, &right_text)) {
+        int is_equal = left_text.length == right_text.length && memcmp(left_text.data, right_text.data, left_text.length) == 0;
+        return LLVMConstInt(LLVMInt1Type(), is_equal, 0);
+    }
+
+    LLVMBuilderRef builder = context->builder;
+    LLVMTypeRef index_type = LLVMIntPtrType(LLVMGetModuleDataLayout(context->module));
+    LLVMValueRef left_data = LLVMBuildExtractValue(builder, left.llvm_value, 0, "");
+    LLVMValueRef right_data = LLVMBuildExtractValue(builder, right.llvm_value, 0, "");
+    LLVMValueRef length = LLVMBuildExtractValue(builder, left.llvm_value, 1, "");
+    LLVMValueRef same_length = LLVMBuildICmp(builder, LLVMIntEQ, length, LLVMBuildExtractValue(builder, right.llvm_value, 1, ""), "");
+
+    LLVMBasicBlockRef entry_block = LLVMGetInsertBlock(builder);
+    LLVMBasicBlockRef cond_block = LLVMAppendBasicBlock(context->current_function, "slice.eq.cond");
+    LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(context->current_function, "slice.eq.body");
+    LLVMBasicBlockRef end_block = LLVMAppendBasicBlock(context->current_function, "slice.eq.end");
+    LLVMBuildCondBr(builder, same_length, cond_block, end_block);
+
+    LLVMPositionBuilderAtEnd(builder, cond_block);
+    LLVMValueRef index = LLVMBuildPhi(builder, index_type, "");
+    LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntEQ, index, length, ""), end_block, body_block);
+
+    LLVMPositionBuilderAtEnd(builder, body_block);
+    unsigned int align = type_align(context, element);
+    LLVMValueRef left_element = codegen_load(context, element, LLVMBuildInBoundsGEP2(builder, element->llvm_type, left_data, &index, 1, ""), align);
+    LLVMValueRef right_element = codegen_load(context, element, LLVMBuildInBoundsGEP2(builder, element->llvm_type, right_data, &index, 1, ""), align);
+    LLVMValueRef next = LLVMBuildNUWAdd(builder, index, LLVMConstInt(index_type, 1, 0), "");
+    LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntEQ, left_element, right_element, ""), cond_block, end_block);
+
+    LLVMValueRef index_incoming[] = { LLVMConstInt(index_type, 0, 0), next };
+    LLVMBasicBlockRef index_blocks[] = { entry_block, body_block };
+    LLVMAddIncoming(index, index_incoming, index_blocks, 2);
+
+    LLVMPositionBuilderAtEnd(builder, end_block);
+    LLVMValueRef result = LLVMBuildPhi(builder, LLVMInt1Type(), "");
+    LLVMValueRef incoming[] = { LLVMConstInt(LLVMInt1Type(), 0, 0), LLVMConstInt(LLVMInt1Type(), 1, 0), LLVMConstInt(LLVMInt1Type(), 0, 0) };
+    LLVMBasicBlockRef blocks[] = { entry_block, cond_block, body_block };
+    LLVMAddIncoming(result, incoming, blocks, 3);
+
+    return result;
+}
+
+// Vectors compare lane by lane into a vector of bools.
+static Value codegen_comparison(CodegenContext* context, BinaryOperatorType operator, Value left, Value right) {
+    Type* type = left.type;
+    Type* element = type_element(type);
+    LLVMValueRef result;
+
+    if (type->kind == TypeKind_Slice && (operator == BinaryOperatorType_Equal || operator == BinaryOperatorType_NotEqual)) {
+        result = codegen_slice_equal(context, left, right);
+        if (operator == BinaryOperatorType_NotEqual) {
+            result = LLVMBuildNot(context->builder, result, "");
+        }
+        return (Value){ result, type_bool(context) };
+    }
+
+    if (element->kind == TypeKind_Float) {
+        LLVMRealPredicate predicate;
+        switch (operator) {
+            case BinaryOperatorType_Equal: predicate = LLVMRealOEQ; break;
+            // NaN compares unequal to everything
+            case BinaryOperatorType_NotEqual: predicate = LLVMRealUNE; break;
+            case BinaryOperatorType_Less: predicate = LLVMRealOLT; break;
+            case BinaryOperatorType_LessEqual: predicate = LLVMRealOLE; break;
+            case BinaryOperatorType_Greater: predicate = LLVMRealOGT; break;
+            default: predicate = LLVMRealOGE; break;
+        }
+        result = LLVMBuildFCmp(context->builder, predicate, left.llvm_value, right.llvm_value, "");
+        codegen_float_flags(context, result);
+    } else {
+        int is_ordering = operator != BinaryOperatorType_Equal && operator != BinaryOperatorType_NotEqual;
+        if ((is_ordering && element->kind != TypeKind_Int) || element->kind == TypeKind_Struct || element->kind == TypeKind_Array
+            || element->kind == TypeKind_Slice) {
+            sil_panic(
+                "Code Gen Error: Operator %s not defined for %.*s",
+                binary_operator_string(operator),
+                type->name.length,
+                type->name.data
+            );
+        }
+
+        LLVMIntPredicate predicate;
+        switch (operator) {
+            case BinaryOperatorType_Equal: predicate = LLVMIntEQ; break;
+            case BinaryOperatorType_NotEqual: predicate = LLVMIntNE; break;
+            case BinaryOperatorType_Less: predicate = type->is_signed ? LLVMIntSLT : LLVMIntULT; break;
+            case BinaryOperatorType_LessEqual: predicate = type->is_signed ? LLVMIntSLE : LLVMIntULE; break;
+            case BinaryOperatorType_Greater: predicate = type->is_signed ? LLVMIntSGT : LLVMIntUGT; break;
+            default: predicate = type->is_signed ? LLVMIntSGE : LLVMIntUGE; break;
+        }
+        result = LLVMBuildICmp(context->builder, predicate, left.llvm_value, right.llvm_value, "");
+    }
+
+    if (type->kind == TypeKind_Vector) {
+        return (Value){ result, type_vector(context, type_bool(context), type->lanes) };
+    }
+    return (Value){ result, type_bool(context) };
+}
+
+// the weights clang gives __builtin_expect
+static void codegen_set_branch_weights(LLVMValueRef instruction, unsigned int taken, unsigned int not_taken) {
+    LLVMContextRef llvm_context = LLVMGetGlobalContext();
+    LLVMMetadataRef operands[] = {
+        LLVMMDStringInContext2(llvm_context, "branch_weights", strlen("branch_weights")),
+        LLVMValueAsMetadata(LLVMConstInt(LLVMInt32Type(), taken, 0)),
+        LLVMValueAsMetadata(LLVMConstInt(LLVMInt32Type(), not_taken, 0)),
+    };
+    LLVMMetadataRef weights = LLVMMDNodeInContext2(llvm_context, operands, 3);
+    LLVMSetMetadata(instruction, LLVMGetMDKindID("prof", strlen("prof")), LLVMMetadataAsValue(llvm_context, weights));
+}
+
+// One trap block per function, placed after all others so it stays out of
+// the hot path even at -O0.
+static LLVMBasicBlockRef codegen_trap_block(CodegenContext* context) {
+    if (context->trap_block == NULL) {
+        LLVMBasicBlockRef current = LLVMGetInsertBlock(context->builder);
+        context->trap_block = LLVMAppendBasicBlock(context->current_function, "trap");
+        LLVMPositionBuilderAtEnd(context->builder, context->trap_block);
+        codegen_intrinsic_call(context, "llvm.trap", NULL, 0, NULL, 0);
+        LLVMBuildUnreachable(context->builder);
+        LLVMPositionBuilderAtEnd(context->builder, current);
+    }
+    return context->trap_block;
+}
+
+// Branches to the trap when failed is true and continues in a block named
+// ok_name otherwise, weighted so the check stays off the hot path.
+static void codegen_trap_if(CodegenContext* context, LLVMValueRef failed, const char* ok_name) {
+    LLVMBasicBlockRef current = LLVMGetInsertBlock(context->builder);
+    LLVMBasicBlockRef next = LLVMGetNextBasicBlock(current);
+    LLVMBasicBlockRef ok = next != NULL
+        ? LLVMInsertBasicBlock(next, ok_name)
+        : LLVMAppendBasicBlock(context->current_function, ok_name);
+
+    LLVMValueRef branch = LLVMBuildCondBr(context->builder, failed, codegen_trap_block(context), ok);
+    codegen_set_branch_weights(branch, 1, 2000);
+    LLVMPositionBuilderAtEnd(context->builder, ok);
+}
+
+// llvm.sadd.with.overflow and friends, branching to the trap on overflow
+static LLVMValueRef codegen_checked_arithmetic(CodegenContext* context, const char* operation, Type* type, LLVMValueRef l, LLVMValueRef r) {
+    char intrinsic[32];
+    snprintf(intrinsic, sizeof(intrinsic), "llvm.%c%s.with.overflow", type_element(type)->is_signed ? 's' : 'u', operation);
+
+    LLVMTypeRef overload = type->llvm_type;
+    LLVMValueRef arguments[] = { l, r };
+    LLVMValueRef call = codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 2);
+    LLVMValueRef result = LLVMBuildExtractValue(context->builder, call, 0, "");
+    LLVMValueRef overflow = LLVMBuildExtractValue(context->builder, call, 1, "");
+    if (type->kind == TypeKind_Vector) {
+        LLVMTypeRef mask_type = LLVMTypeOf(overflow);
+        overflow = codegen_intrinsic_call(context, "llvm.vector.reduce.or", &mask_type, 1, &overflow, 1);
+    }
+
+    codegen_trap_if(context, overflow, "overflow.ok");
+
+    return result;
+}
+
+// Plain + - * may not overflow: checked builds trap, fast builds tell LLVM
+// with nsw/nuw. The % forms wrap and the | forms saturate.
+static LLVMValueRef codegen_integer_arithmetic(CodegenContext* context, BinaryOperatorType operator, Type* type, LLVMValueRef l, LLVMValueRef r) {
+    LLVMBuilderRef builder = context->builder;
+    int is_signed = type_element(type)->is_signed;
+    int checked = context->options->overflow_checks;
+
+    char intrinsic[32];
+    LLVMTypeRef overload = type->llvm_type;
+    switch (operator) {
+        case BinaryOperatorType_Addition:
+            if (checked) {
+                return codegen_checked_arithmetic(context, "add", type, l, r);
+            }
+            return is_signed ? LLVMBuildNSWAdd(builder, l, r, "") : LLVMBuildNUWAdd(builder, l, r, "");
+        case BinaryOperatorType_Subtraction:
+            if (checked) {
+                return codegen_checked_arithmetic(context, "sub", type, l, r);
+            }
+            return is_signed ? LLVMBuildNSWSub(builder, l, r, "") : LLVMBuildNUWSub(builder, l, r, "");
+        case BinaryOperatorType_Multiplication:
+            if (checked) {
+                return codegen_checked_arithmetic(context, "mul", type, l, r);
+            }
+            return is_signed ? LLVMBuildNSWMul(builder, l, r, "") : LLVMBuildNUWMul(builder, l, r, "");
+        case BinaryOperatorType_WrappingAddition:
+            return LLVMBuildAdd(builder, l, r, "");
+        case BinaryOperatorType_WrappingSubtraction:
+            return LLVMBuildSub(builder, l, r, "");
+        case BinaryOperatorType_WrappingMultiplication:
+            return LLVMBuildMul(builder, l, r, "");
+        case BinaryOperatorType_SaturatingAddition:
+        case BinaryOperatorType_SaturatingSubtraction: {
+            const char* operation = operator == BinaryOperatorType_SaturatingAddition ? "add" : "sub";
+            snprintf(intrinsic, sizeof(intrinsic), "llvm.%c%s.sat", is_signed ? 's' : 'u', operation);
+            LLVMValueRef arguments[] = { l, r };
+            return codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 2);
+        }
+        case BinaryOperatorType_SaturatingMultiplication: {
+            // a fixed point multiply with no fraction bits
+            snprintf(intrinsic, sizeof(intrinsic), "llvm.%cmul.fix.sat", is_signed ? 's' : 'u');
+            LLVMValueRef arguments[] = { l, r, LLVMConstInt(LLVMInt32Type(), 0, 0) };
+            return codegen_intrinsic_call(context, intrinsic, &overload, 1, arguments, 3);
+        }
+        default:
+            sil_panic("Code Gen Error: Unhandled infix operator");
+    }
+}
+
+static Value codegen_binary_operator(CodegenContext* context, AstNode* expression, Type* expected) {
+    BinaryOperatorType operator = expression->data.binary_operator.type;
+    AstNode* left_node = expression->data.binary_operator.left;
+    AstNode* right_node = expression->data.binary_operator.right;
+
+    int is_comparison = operator >= BinaryOperatorType_Equal;
+    int is_shift = operator == BinaryOperatorType_ShiftLeft || operator == BinaryOperatorType_ShiftRight;
+    Type* operand_type = is_comparison ? NULL : expected;
+
+    // a literal operand takes the type of the other side, so the typed side
+    // is generated first; literals have no side effects to reorder
+    Value left;
+    Value right;
+    if (is_shift) {
+        left = codegen_expression(context, left_node, operand_type);
+        right = codegen_expression(context, right_node, is_number_literal(right_node) ? left.type : NULL);
+    } else if (is_number_literal(left_node) && !is_number_literal(right_node)) {
+        right = codegen_expression(context, right_node, operand_type);
+        left = codegen_expression(context, left_node, right.type);
+    } else {
+        left = codegen_expression(context, left_node, operand_type);
+        right = codegen_expression(context, right_node, left.type);
+    }
+
+    if (is_shift) {
+        if (type_element(left.type)->kind != TypeKind_Int || type_element(right.type)->kind != TypeKind_Int) {
+            sil_panic("Code Gen Error: Operator %s needs integer operands", binary_operator_string(operator));
+        }
+
+        // one amount shifts every lane
+        if (left.type->kind == TypeKind_Vector && right.type->kind != TypeKind_Vector) {
+            right = (Value){ codegen_splat(context, right.llvm_value, type_vector(context, right.type, left.type->lanes)), right.type };
+        } else if (left.type->kind != TypeKind_Vector && right.type->kind == TypeKind_Vector) {
+            sil_panic("Code Gen Error: Cannot shift a scalar by a vector");
+        }
+
+        // the shift amount is unsigned and adopts the width of the shifted value
+        LLVMValueRef amount = LLVMBuildIntCast2(context->builder, right.llvm_value, left.type->llvm_type, 0, "");
+        if (operator == BinaryOperatorType_ShiftLeft) {
+            return (Value){ LLVMBuildShl(context->builder, left.llvm_value, amount, ""), left.type };
+        }
+        if (left.type->is_signed) {
+            return (Value){ LLVMBuildAShr(context->builder, left.llvm_value, amount, ""), left.type };
+        }
+        return (Value){ LLVMBuildLShr(context->builder, left.llvm_value, amount, ""), left.type };
+    }
+
+    // mixed operands widen to the larger type instead of a default int
+    if (type_coerces_to(left.type, right.type)) {
+        left = codegen_coerce(context, left, right.type);
+    } else {
+        right = codegen_coerce(context, right, left.type);
+    }
+    Type* type = left.type;
+
+    if (is_comparison) {
+        return codegen_comparison(context, operator, left, right);
+    }
+
+    // vectors apply the operator lane by lane
+    Type* element = type_element(type);
+    int is_int = element->kind == TypeKind_Int;
+    int is_float = element->kind == TypeKind_Float;
+    int is_bitwise = operator == BinaryOperatorType_BitwiseAnd
+        || operator == BinaryOperatorType_BitwiseOr
+        || operator == BinaryOperatorType_BitwiseXor;
+    int is_integer_only = is_bitwise
+        || (operator >= BinaryOperatorType_WrappingAddition && operator <= BinaryOperatorType_SaturatingMultiplication);
+    if (!(is_int || (is_float && !is_integer_only) || (element->kind == TypeKind_Bool && is_bitwise))) {
+        sil_panic(
+            "Code Gen Error: Operator %s not defined for %.*s",
+            binary_operator_string(operator),
+            type->name.length,
+            type->name.data
+        );
+    }
+
+    LLVMBuilderRef builder = context->builder;
+    LLVMValueRef l = left.llvm_value;
+    LLVMValueRef r = right.llvm_value;
+    LLVMValueRef result;
+    switch (operator) {
+        case BinaryOperatorType_Addition:
+            result = is_float ? LLVMBuildFAdd(builder, l, r, "") : codegen_integer_arithmetic(context, operator, type, l, r);
+            break;
+        case BinaryOperatorType_Subtraction:
+            result = is_float ? LLVMBuildFSub(builder, l, r, "") : codegen_integer_arithmetic(context, operator, type, l, r);
+            break;
+        case BinaryOperatorType_Multiplication:
+            result = is_float ? LLVMBuildFMul(builder, l, r, "") : codegen_integer_arithmetic(context, operator, type, l, r);
+            break;
+        case BinaryOperatorType_WrappingAddition:
+        case BinaryOperatorType_WrappingSubtraction:
+        case BinaryOperatorType_WrappingMultiplication:
+        case BinaryOperatorType_SaturatingAddition:
+        case BinaryOperatorType_SaturatingSubtraction:
+        case BinaryOperatorType_SaturatingMultiplication:
+            result = codegen_integer_arithmetic(context, operator, type, l, r);
+            break;
+        case BinaryOperatorType_Division:
+            if (is_float) {
+                result = LLVMBuildFDiv(builder, l, r, "");
+            } else {
+                result = type->is_signed ? LLVMBuildSDiv(builder, l, r, "") : LLVMBuildUDiv(builder, l, r, "");
+            }
+            break;
+        case BinaryOperatorType_Remainder:
+            if (is_float) {
+                result = LLVMBuildFRem(builder, l, r, "");
+            } else {
+                result = type->is_signed ? LLVMBuildSRem(builder, l, r, "") : LLVMBuildURem(builder, l, r, "");
+            }
+            break;
+        case BinaryOperatorType_BitwiseAnd:
+            result = LLVMBuildAnd(builder, l, r, "");
+            break;
+        case BinaryOperatorType_BitwiseOr:
+            result = LLVMBuildOr(builder, l, r, "");
+            break;
+        case BinaryOperatorType_BitwiseXor:
+            result = LLVMBuildXor(builder, l, r, "");
+            break;
+        default:
+            sil_panic("Code Gen Error: Unhandled infix operator");
+    }
+
+    if (is_float) {
+        codegen_float_flags(context, result);
+    }
+
+    return (Value){ result, type };
+}
+
+static Value codegen_unary_operator(CodegenContext* context, AstNode* expression, Type* expected) {
+    UnaryOperatorType operator = expression->data.unary_operator.type;
+    AstNode* operand = expression->data.unary_operator.value;
+    if (operator == UnaryOperatorType_Negation && operand->type == AstNodeType_PrimaryExpression
+        && operand->data.primary_expression.type == PrimaryExpressionType_Number) {
+        return codegen_number(context, operand->data.primary_expression.number, expected, 1);
+    }
+
+    Value value = codegen_expression(context, operand, expected);
+    Type* type = value.type;
+    Type* element = type_element(type);
+
+    switch (operator) {
+        case UnaryOperatorType_Negation:
+            if (element->kind == TypeKind_Float) {
+                LLVMValueRef negated = LLVMBuildFNeg(context->builder, value.llvm_value, "");
+                codegen_float_flags(context, negated);
+                return (Value){ negated, type };
+            }
+            // negating a signed value can overflow like a subtraction;
+            // unsigned negation stays two's complement, as in x & -x
+            if (element->kind == TypeKind_Int && element->is_signed) {
+                LLVMValueRef zero = LLVMConstNull(type->llvm_type);
+                return (Value){ codegen_integer_arithmetic(context, BinaryOperatorType_Subtraction, type, zero, value.llvm_value), type };
+            }
+            if (element->kind == TypeKind_Int) {
+                return (Value){ LLVMBuildNeg(context->builder, value.llvm_value, ""), type };
+            }
+            break;
+        case UnaryOperatorType_BitwiseComplement:
+            if (element->kind == TypeKind_Int) {
+                return (Value){ LLVMBuildNot(context->builder, value.llvm_value, ""), type };
+            }
+            break;
+        case UnaryOperatorType_LogicalNegation:
+            if (element->kind == TypeKind_Bool) {
+                return (Value){ LLVMBuildNot(context->builder, value.llvm_value, ""), type };
+            }
+            break;
+        default:
+            sil_panic("Code Gen Error: Unhandled unary operator");
+    }
+
+    sil_panic("Code Gen Error: Unary operator not defined for %.*s", type->name.length, type->name.data);
+}
+
+static Value codegen_block(CodegenContext* context, AstNode* block, Type* expected);
+
+static Value codegen_void(CodegenContext* context) {
+    return (Value){ NULL, type_void(context) };
+}
+
+static int codegen_block_terminated(CodegenContext* context) {
+    return LLVMGetBasicBlockTerminator(LLVMGetInsertBlock(context->builder)) != NULL;
+}
+
+static void codegen_apply_branch_hint(LLVMValueRef instruction, BranchHint hint) {
+    if (hint == BranchHint_Likely) {
+        codegen_set_branch_weights(instruction, 2000, 1);
+    } else if (hint == BranchHint_Unlikely) {
+        codegen_set_branch_weights(instruction, 1, 2000);
+    }
+}
+
+// Estimated instructions to evaluate an arm unconditionally, or SELECT_NEVER
+// for arms with side effects or that may trap.
+#define SELECT_NEVER 1000
+#define SELECT_MAX_COST 2
+
+static int select_cost(CodegenContext* context, AstNode* expression) {
+    switch (expression->type) {
+        case AstNodeType_PrimaryExpression:
+            switch (expression->data.primary_expression.type) {
+                case PrimaryExpressionType_Number:
+                case PrimaryExpressionType_Bool:
+                case PrimaryExpressionType_Variable:
+                    return 0;
+                default:
+                    return SELECT_NEVER;
+            }
+        case AstNodeType_UnaryOperator:
+            if (context->options->overflow_checks && expression->data.unary_operator.type == UnaryOperatorType_Negation) {
+                return SELECT_NEVER;
+            }
+            return 1 + select_cost(context, expression->data.unary_operator.value);
+        case AstNodeType_BinaryOperator: {
+            BinaryOperatorType operator = expression->data.binary_operator.type;
+            if (operator == BinaryOperatorType_Division || operator == BinaryOperatorType_Remainder) {
+                return SELECT_NEVER;
+            }
+            // checked arithmetic traps on overflow
+            if (context->options->overflow_checks && operator <= BinaryOperatorType_Multiplication) {
+                return SELECT_NEVER;
+            }
+            return 1 + select_cost(context, expression->data.binary_operator.left) + select_cost(context, expression->data.binary_operator.right);
+        }
+        default:
+            return SELECT_NEVER;
+    }
+}
+
+static int arm_is_selectable(CodegenContext* context, AstNode* arm) {
+    return arm != NULL
+        && arm->type == AstNodeType_Block
+        && arm->data.block.statement_list.length == 0
+        && arm->data.block.value != NULL
+        && select_cost(context, arm->data.block.value) <= SELECT_MAX_COST;
+}
+
+static Value codegen_if_select(CodegenContext* context, Value condition, AstNode* if_expression, BranchHint hint, Type* expected) {
+    AstNode* then_node = if_expression->data.if_expression.body->data.block.value;
+    AstNode* else_node = if_expression->data.if_expression.alt->data.block.value;
+
+    // both arms are pure, so a literal arm can wait for the other's type
+    Value then_value;
+    Value else_value;
+    if (is_number_literal(then_node) && !is_number_literal(else_node)) {
+        else_value = codegen_expression(context, else_node, expected);
+        then_value = codegen_expression(context, then_node, else_value.type);
+    } else {
+        then_value = codegen_expression(context, then_node, expected);
+        else_value = codegen_expression(context, else_node, then_value.type);
+    }
+
+    if (type_coerces_to(then_value.type, else_value.type)) {
+        then_value = codegen_coerce(context, then_value, else_value.type);
+    } else {
+        else_value = codegen_coerce(context, else_value, then_value.type);
+    }
+
+    LLVMValueRef select = LLVMBuildSelect(
+        context->builder,
+        condition.llvm_value,
+        then_value.llvm_value,
+        else_value.llvm_value,
+        ""
+    );
+    if (LLVMIsAInstruction(select)) {
+        codegen_apply_branch_hint(select, hint);
+    }
+
+    return (Value){ select, then_value.type };
+}
+
+static Value codegen_if_arm(CodegenContext* context, AstNode* arm, Type* expected) {
+    if (arm->type == AstNodeType_Block) {
+        return codegen_block(context, arm, expected);
+    }
+    return codegen_expression(context, arm, expected);
+}
+
+static Value codegen_if(CodegenContext* context, AstNode* if_expression, Type* expected) {
+    AstNode* condition_node = if_expression->data.if_expression.condition;
+    AstNode* alt = if_expression->data.if_expression.alt;
+
+    BranchHint hint = builtin_branch_hint(condition_node);
+    if (hint != BranchHint_None) {
+        List* arguments = &condition_node->data.primary_expression.function_call.parameters;
+        if (arguments->length != 1) {
+            sil_panic("Code Gen Error: Branch hints take one bool");
+        }
+        condition_node = *list_get(AstNode*, arguments, 0);
+    }
+
+    Type* bool_type = type_bool(context);
+    Value condition = codegen_expression(context, condition_node, bool_type);
+    if (condition.type != bool_type) {
+        sil_panic("Code Gen Error: if condition must be bool, got %.*s", condition.type->name.length, condition.type->name.data);
+    }
+
+    if (arm_is_selectable(context, if_expression->data.if_expression.body) && arm_is_selectable(context, alt)) {
+        return codegen_if_select(context, condition, if_expression, hint, expected);
+    }
+
+    LLVMBasicBlockRef then_block = LLVMAppendBasicBlock(context->current_function, "if.then");
+    LLVMBasicBlockRef else_block = alt != NULL ? LLVMAppendBasicBlock(context->current_function, "if.else") : NULL;
+    LLVMBasicBlockRef merge_block = LLVMAppendBasicBlock(context->current_function, "if.end");
+
+    LLVMValueRef branch = LLVMBuildCondBr(
+        context->builder,
+        condition.llvm_value,
+        then_block,
+        else_block != NULL ? else_block : merge_block
+    );
+    codegen_apply_branch_hint(branch, hint);
+
+    LLVMPositionBuilderAtEnd(context->builder, then_block);
+    Value then_value = codegen_if_arm(context, if_expression->data.if_expression.body, expected);
+    LLVMBasicBlockRef then_end = LLVMGetInsertBlock(context->builder);
+    int then_open = !codegen_block_terminated(context);
+
+    Value else_value = codegen_void(context);
+    LLVMBasicBlockRef else_end = NULL;
+    int else_open = alt == NULL;
+    if (alt != NULL) {
+        LLVMPositionBuilderAtEnd(context->builder, else_block);
+        Type* else_expected = then_value.type->kind != TypeKind_Void ? then_value.type : expected;
+        else_value = codegen_if_arm(context, alt, else_expected);
+        else_end = LLVMGetInsertBlock(context->builder);
+        else_open = !codegen_block_terminated(context);
+    }
+
+    // an arm that returned contributes nothing to the result
+    Value result = codegen_void(context);
+    if (alt != NULL && then_open && else_open) {
+        if (then_value.type->kind != TypeKind_Void && else_value.type->kind != TypeKind_Void) {
+            Type* type = type_coerces_to(then_value.type, else_value.type) ? else_value.type : then_value.type;
+
+            LLVMPositionBuilderAtEnd(context->builder, then_end);
+            then_value = codegen_coerce(context, then_value, type);
+            LLVMPositionBuilderAtEnd(context->builder, else_end);
+            else_value = codegen_coerce(context, else_value, type);
+            result.type = type;
+        }
+    } else if (alt != NULL && then_open) {
+        result = then_value;
+    } else if (alt != NULL && else_open) {
+        result = else_value;
+    }
+
+    if (then_open) {
+        LLVMPositionBuilderAtEnd(context->builder, then_end);
+        LLVMBuildBr(context->builder, merge_block);
+    }
+    if (alt != NULL && else_open) {
+        LLVMPositionBuilderAtEnd(context->builder, else_end);
+        LLVMBuildBr(context->builder, merge_block);
+    }
+
+    if (!then_open && !else_open) {
+        // nothing falls through, so the if itself never finishes; leave the
+        // builder in the terminated arm
+        LLVMDeleteBasicBlock(merge_block);
+        result.type = type_never(context);
+        return result;
+    }
+
+    LLVMPositionBuilderAtEnd(context->builder, merge_block);
+    if (then_open && else_open && result.type->kind != TypeKind_Void) {
+        LLVMValueRef phi = LLVMBuildPhi(context->builder, result.type->llvm_type, "");
+        LLVMValueRef values[] = { then_value.llvm_value, else_value.llvm_value };
+        LLVMBasicBlockRef blocks[] = { then_end, else_end };
+        LLVMAddIncoming(phi, values, blocks, 2);
+        result.llvm_value = phi;
+    }
+
+    return result;
+}
+
+// Inline assembly, lowered to an LLVM inline asm call. Without an output, or
+// when volatile, it has side effects and is never removed or reordered with
+// other side effects. Otherwise it is a pure function of its inputs that
+// LLVM may merge or hoist, unless it clobbers memory.
+static Value codegen_asm(CodegenContext* context, AstNode* node) {
+    AstNodeAsm* asm_expression = &node->data.asm_expression;
+
+    // LLVM constraint syntax: "=r,r,i,~{memory}"
+    List constraints = {0};
+    Type* output_type = type_void(context);
+    if (asm_expression->output_constraint.length > 0) {
+        output_type = type_from_ast(context, asm_expression->output_type);
+        mca_append_text(&constraints, asm_expression->output_constraint.data, asm_expression->output_constraint.length);
+    }
+
+    size_t input_count = asm_expression->inputs.length;
+    LLVMTypeRef* param_types = malloc(sizeof(LLVMTypeRef) * (input_count > 0 ? input_count : 1));
+    LLVMValueRef* arguments = malloc(sizeof(LLVMValueRef) * (input_count > 0 ? input_count : 1));
+    for (size_t i = 0; i < input_count; i++) {
+        AsmOperand* input = list_get(AsmOperand, &asm_expression->inputs, i);
+        Value value = codegen_expression(context, input->value, NULL);
+        if (value.llvm_value == NULL) {
+            sil_panic("Code Gen Error: asm input \"%.*s\" has no value", input->constraint.length, input->constraint.data);
+        }
+
+        int is_immediate = string_compare(input->constraint, string_from_literal("i"))
+            || string_compare(input->constraint, string_from_literal("n"));
+        if (is_immediate && !LLVMIsConstant(value.llvm_value)) {
+            sil_panic("Code Gen Error: asm input \"%.*s\" needs a constant", input->constraint.length, input->constraint.data);
+        }
+
+        param_types[i] = value.type->llvm_type;
+        arguments[i] = value.llvm_value;
+        if (constraints.length > 0) {
+            *list_add(char, &constraints) = ',';
+        }
+        mca_append_text(&constraints, input->constraint.data, input->constraint.length);
+    }
+
+    int clobbers_memory = 0;
+    for (size_t i = 0; i < asm_expression->clobbers.length; i++) {
+        String clobber = *list_get(String, &asm_expression->clobbers, i);
+        clobbers_memory |= string_compare(clobber, string_from_literal("memory"));
+
+        if (constraints.length > 0) {
+            *list_add(char, &constraints) = ',';
+        }
+        mca_append_text(&constraints, "~{", 2);
+        mca_append_text(&constraints, clobber.data, clobber.length);
+        *list_add(char, &constraints) = '}';
+    }
+    size_t constraints_length = constraints.length;
+    *list_add(char, &constraints) = 0;
+
+    int has_side_effects = asm_expression->is_volatile || output_type->kind == TypeKind_Void;
+    if (has_side_effects || clobbers_memory) {
+        codegen_check_pure(context, "has asm with side effects");
+    }
+    LLVMTypeRef fn_type = LLVMFunctionType(output_type->llvm_type, param_types, input_count, 0);
+    LLVMValueRef inline_asm = LLVMGetInlineAsm(
+        fn_type,
+        asm_expression->template.data,
+        asm_expression->template.length,
+        constraints.data,
+        constraints_length,
+        has_side_effects,
+        0,
+        LLVMInlineAsmDialectATT,
+        0
+    );
+    LLVMValueRef call = LLVMBuildCall2(context->builder, fn_type, inline_asm, arguments, input_count, "");
+
+    if (!has_side_effects && !clobbers_memory) {
+        unsigned int kind = LLVMGetEnumAttributeKindForName("readnone", strlen("readnone"));
+        LLVMAttributeRef readnone = LLVMCreateEnumAttribute(LLVMGetGlobalContext(), kind, 0);
+        LLVMAddCallSiteAttribute(call, LLVMAttributeFunctionIndex, readnone);
+    }
+
+    free(param_types);
+    free(arguments);
+    list_delete(&constraints);
+
+    return (Value){ output_type->kind == TypeKind_Void ? NULL : call, output_type };
+}
+
+// Where break and continue of the innermost loop jump to.
+typedef struct LoopTarget {
+    LLVMBasicBlockRef break_block;
+    LLVMBasicBlockRef continue_block;
+    int has_break;
+} LoopTarget;
+
+// A for loop counter, which is never negative when its range proves it: then
+// it is below end when has_end is set, and below the length of slice when
+// that is set.
+typedef struct LoopRange {
+    LLVMValueRef counter;
+    int has_end;
+    uint64_t end;
+    LLVMValueRef slice;
+} LoopRange;
+
+static LLVMMetadataRef loop_hint(LLVMContextRef llvm_context, const char* name, LLVMValueRef value) {
+    LLVMMetadataRef operands[] = {
+        LLVMMDStringInContext2(llvm_context, name, strlen(name)),
+        value != NULL ? LLVMValueAsMetadata(value) : NULL,
+    };
+    return LLVMMDNodeInContext2(llvm_context, operands, value != NULL ? 2 : 1);
+}
+
+// Hints become llvm.loop metadata on the latch branch, which the loop
+// passes read back: !0 = distinct !{!0, !{!"llvm.loop.unroll.count", i32 4}}
+static void codegen_set_loop_hints(LLVMValueRef latch, AstLoopHints hints) {
+    // a delay loop is never unrolled unless asked to
+    if (hints.is_volatile && hints.unroll == 0) {
+        hints.unroll = -2;
+    }
+    if (hints.unroll == 0 && hints.vectorize_width == 0) {
+        return;
+    }
+
+    LLVMContextRef llvm_context = LLVMGetGlobalContext();
+    LLVMMetadataRef operands[4];
+    unsigned int count = 0;
+
+    // loop ids refer to themselves so that no two loops share one
+    LLVMMetadataRef self = LLVMTemporaryMDNode(llvm_context, NULL, 0);
+    operands[count++] = self;
+
+    if (hints.unroll == -1) {
+        operands[count++] = loop_hint(llvm_context, "llvm.loop.unroll.full", NULL);
+    } else if (hints.unroll == -2) {
+        operands[count++] = loop_hint(llvm_context, "llvm.loop.unroll.disable", NULL);
+    } else if (hints.unroll > 0) {
+        LLVMValueRef unroll = LLVMConstInt(LLVMInt32Type(), hints.unroll, 0);
+        operands[count++] = loop_hint(llvm_context, "llvm.loop.unroll.count", unroll);
+    }
+
+    if (hints.vectorize_width > 0) {
+        LLVMValueRef width = LLVMConstInt(LLVMInt32Type(), hints.vectorize_width, 0);
+        LLVMValueRef enable = LLVMConstInt(LLVMInt1Type(), hints.vectorize_width > 1, 0);
+        operands[count++] = loop_hint(llvm_context, "llvm.loop.vectorize.width", width);
+        operands[count++] = loop_hint(llvm_context, "llvm.loop.vectorize.enable", enable);
+    }
+
+    LLVMMetadataRef loop_id = LLVMMDNodeInContext2(llvm_context, operands, count);
+    LLVMMetadataReplaceAllUsesWith(self, loop_id);
+    LLVMSetMetadata(latch, LLVMGetMDKindID("llvm.loop", strlen("llvm.loop")), LLVMMetadataAsValue(llvm_context, loop_id));
+}
+
+// Returns whether the body breaks out of the loop.
+static int codegen_loop_body(CodegenContext* context, AstNode* body, LLVMBasicBlockRef break_block, LLVMBasicBlockRef continue_block) {
+    LoopTarget target = { break_block, continue_block, 0 };
+    list_push(LoopTarget, &context->loop_targets, &target);
+    codegen_block(context, body, NULL);
+
+    context->loop_targets.length -= 1;
+    target = *list_get(LoopTarget, &context->loop_targets, context->loop_targets.length);
+    return target.has_break;
+}
+
+// Leaves the builder after the loop, or terminated when nothing breaks out
+// of an endless loop.
+static void codegen_loop_exit(CodegenContext* context, LLVMBasicBlockRef end_block, int reachable) {
+    if (!reachable) {
+        LLVMDeleteBasicBlock(end_block);
+        return;
+    }
+    LLVMPositionBuilderAtEnd(context->builder, end_block);
+}
+
+// for i in [start..end] is the half-open range, lowered to the shape LLVM's
+// induction variable analysis expects: a counter compared against an end
+// evaluated once, stepped by one without wrapping in the latch.
+// s when expression is s.len of a slice that cannot change, an immutable
+// local held as a value.
+static LLVMValueRef codegen_length_of_slice(CodegenContext* context, AstNode* expression) {
+    if (expression->type != AstNodeType_FieldAccess || !string_compare(expression->data.field_access.field, string_from_literal("len"))) {
+        return NULL;
+    }
+
+    AstNode* value = expression->data.field_access.value;
+    if (value->type != AstNodeType_PrimaryExpression || value->data.primary_expression.type != PrimaryExpressionType_Variable) {
+        return NULL;
+    }
+
+    PrimaryExpressionVariable* variable = &value->data.primary_expression.variable;
+    Local local = codegen_find_local(context, variable->name, variable->symbol);
+    if (local.in_memory || local.value.type->kind != TypeKind_Slice) {
+        return NULL;
+    }
+    return local.value.llvm_value;
+}
+
+static LoopRange codegen_loop_range(CodegenContext* context, AstNodeStatementFor* loop, LLVMValueRef counter, Value start, Value end) {
+    LoopRange range = { counter, 0, 0, NULL };
+
+    int is_non_negative = !start.type->is_signed
+        || (LLVMIsAConstantInt(start.llvm_value) && LLVMConstIntGetSExtValue(start.llvm_value) >= 0);
+    if (!is_non_negative) {
+        return range;
+    }
+
+    if (LLVMIsAConstantInt(end.llvm_value)) {
+        int64_t last = end.type->is_signed ? LLVMConstIntGetSExtValue(end.llvm_value) : (int64_t)LLVMConstIntGetZExtValue(end.llvm_value);
+        if (end.type->is_signed ? last > 0 : last != 0) {
+            range.has_end = 1;
+            range.end = (uint64_t)last;
+        }
+    }
+    range.slice = codegen_length_of_slice(context, loop->end);
+
+    return range;
+}
+
+static void codegen_for(CodegenContext* context, AstNode* statement) {
+    AstNodeStatementFor* loop = &statement->data.statement_for;
+
+    Value start, end;
+    if (is_number_literal(loop->start) && !is_number_literal(loop->end)) {
+        end = codegen_expression(context, loop->end, NULL);
+        start = codegen_expression(context, loop->start, end.type);
+    } else {
+        start = codegen_expression(context, loop->start, NULL);
+        end = codegen_expression(context, loop->end, start.type);
+    }
+
+    Type* type = type_coerces_to(start.type, end.type) ? end.type : start.type;
+    if (type->kind != TypeKind_Int) {
+        sil_panic("Code Gen Error: for ranges must be integers, got %.*s", type->name.length, type->name.data);
+    }
+    start = codegen_coerce(context, start, type);
+    end = codegen_coerce(context, end, type);
+
+    // mem2reg turns the counter into a phi; a volatile one stays in memory
+    // so every iteration is kept
+    LLVMValueRef counter = codegen_entry_alloca(context, type, loop->name);
+    LLVMValueRef store = LLVMBuildStore(context->builder, start.llvm_value, counter);
+    LLVMSetVolatile(store, loop->hints.is_volatile);
+
+    LLVMBasicBlockRef cond_block = LLVMAppendBasicBlock(context->current_function, "for.cond");
+    LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(context->current_function, "for.body");
+    LLVMBasicBlockRef inc_block = LLVMAppendBasicBlock(context->current_function, "for.inc");
+    LLVMBasicBlockRef end_block = LLVMAppendBasicBlock(context->current_function, "for.end");
+    LLVMBuildBr(context->builder, cond_block);
+
+    LLVMPositionBuilderAtEnd(context->builder, cond_block);
+    LLVMValueRef index = LLVMBuildLoad2(context->builder, type->llvm_type, counter, loop->name.data);
+    LLVMSetVolatile(index, loop->hints.is_volatile);
+    LLVMIntPredicate predicate = type->is_signed ? LLVMIntSLT : LLVMIntULT;
+    LLVMValueRef in_range = LLVMBuildICmp(context->builder, predicate, index, end.llvm_value, "");
+    LLVMBuildCondBr(context->builder, in_range, body_block, end_block);
+
+    LLVMPositionBuilderAtEnd(context->builder, body_block);
+    scope_push(&context->symbols);
+    codegen_add_local(context, loop->name, loop->symbol, (Value){ index, type }, 0, 0);
+    LoopRange range = codegen_loop_range(context, loop, index, start, end);
+    list_push(LoopRange, &context->loop_ranges, &range);
+    codegen_loop_body(context, loop->body, end_block, inc_block);
+    context->loop_ranges.length -= 1;
+    scope_pop(&context->symbols);
+    if (!codegen_block_terminated(context)) {
+        LLVMBuildBr(context->builder, inc_block);
+    }
+
+    // index < end, so index + 1 cannot wrap
+    LLVMPositionBuilderAtEnd(context->builder, inc_block);
+    LLVMValueRef one = LLVMConstInt(type->llvm_type, 1, 0);
+    LLVMValueRef next = type->is_signed
+        ? LLVMBuildNSWAdd(context->builder, index, one, "")
+        : LLVMBuildNUWAdd(context->builder, index, one, "");
+    store = LLVMBuildStore(context->builder, next, counter);
+    LLVMSetVolatile(store, loop->hints.is_volatile);
+    codegen_set_loop_hints(LLVMBuildBr(context->builder, cond_block), loop->hints);
+
+    uint64_t trip_count = WCET_UNBOUNDED;
+    if (LLVMIsAConstantInt(start.llvm_value) && LLVMIsAConstantInt(end.llvm_value)) {
+        int64_t first = type->is_signed ? LLVMConstIntGetSExtValue(start.llvm_value) : (int64_t)LLVMConstIntGetZExtValue(start.llvm_value);
+        int64_t last = type->is_signed ? LLVMConstIntGetSExtValue(end.llvm_value) : (int64_t)LLVMConstIntGetZExtValue(end.llvm_value);
+        trip_count = type->is_signed
+            ? (last > first ? (uint64_t)(last - first) : 0)
+            : ((uint64_t)last > (uint64_t)first ? (uint64_t)last - (uint64_t)first : 0);
+    }
+
+    // rotation and unrolling move the header, so tag every block
+    int loop_id = wcet_add_loop(context, trip_count);
+    wcet_mark_loop_block(context, cond_block, loop_id);
+    wcet_mark_loop_block(context, body_block, loop_id);
+    wcet_mark_loop_block(context, inc_block, loop_id);
+
+    codegen_loop_exit(context, end_block, 1);
+}
+
+// while condition, or loop when there is none
+static void codegen_while(CodegenContext* context, AstNode* statement) {
+    AstNodeStatementWhile* loop = &statement->data.statement_while;
+    int is_endless = loop->condition == NULL;
+    codegen_check_pure(context, is_endless ? "has a loop without a bound" : "has a while loop without a bound");
+
+    LLVMBasicBlockRef cond_block = is_endless ? NULL : LLVMAppendBasicBlock(context->current_function, "while.cond");
+    LLVMBasicBlockRef body_block = LLVMAppendBasicBlock(context->current_function, is_endless ? "loop.body" : "while.body");
+    LLVMBasicBlockRef end_block = LLVMAppendBasicBlock(context->current_function, is_endless ? "loop.end" : "while.end");
+    LLVMBasicBlockRef header = is_endless ? body_block : cond_block;
+    LLVMBuildBr(context->builder, header);
+
+    if (!is_endless) {
+        LLVMPositionBuilderAtEnd(context->builder, cond_block);
+
+        Type* bool_type = type_bool(context);
+        Value condition = codegen_expression(context, loop->condition, bool_type);
+        if (condition.type != bool_type) {
+            sil_panic("Code Gen Error: while condition must be bool, got %.*s", condition.type->name.length, condition.type->name.data);
+        }
+        LLVMBuildCondBr(context->builder, condition.llvm_value, body_block, end_block);
+    }
+
+    LLVMPositionBuilderAtEnd(context->builder, body_block);
+    int has_break = codegen_loop_body(context, loop->body, end_block, header);
+
+    if (!codegen_block_terminated(context)) {
+        // an empty asm with side effects keeps a volatile loop from being deleted
+        if (loop->hints.is_volatile) {
+            LLVMTypeRef asm_type = LLVMFunctionType(LLVMVoidType(), NULL, 0, 0);
+            LLVMValueRef barrier = LLVMGetInlineAsm(asm_type, "", 0, "", 0, 1, 0, LLVMInlineAsmDialectATT, 0);
+            LLVMBuildCall2(context->builder, asm_type, barrier, NULL, 0, "");
+        }
+        codegen_set_loop_hints(LLVMBuildBr(context->builder, header), loop->hints);
+    }
+
+    codegen_loop_exit(context, end_block, !is_endless || has_break);
+}
+
+static Value codegen_struct_literal(CodegenContext* context, AstNode* expression) {
+    AstNodeStructLiteral* literal = &expression->data.struct_literal;
+    Type* type = type_named(context, literal->name);
+
+    // starts from zero so the padding bytes are defined
+    LLVMValueRef value = LLVMConstNull(type->llvm_type);
+    int* is_set = calloc(type->fields.length, sizeof(int));
+
+    for (int i = 0; i < literal->fields.length; i++) {
+        StructLiteralField* initializer = list_get(StructLiteralField, &literal->fields, i);
+        StructField* field = type_field(type, initializer->name);
+        if (field == NULL) {
+            sil_panic("Code Gen Error: %.*s has no field %.*s", type->name.length, type->name.data, initializer->name.length, initializer->name.data);
+        }
+
+        int field_number = field - (StructField*)type->fields.data;
+        if (is_set[field_number]) {
+            sil_panic("Code Gen Error: Field %.*s set twice", initializer->name.length, initializer->name.data);
+        }
+        is_set[field_number] = 1;
+
+        Value field_value = codegen_expression(context, initializer->value, field->type);
+        field_value = codegen_coerce(context, field_value, field->type);
+        value = LLVMBuildInsertValue(context->builder, value, field_value.llvm_value, field->index, "");
+    }
+
+    for (int i = 0; i < type->fields.length; i++) {
+        if (!is_set[i]) {
+            StructField* field = list_get(StructField, &type->fields, i);
+            sil_panic("Code Gen Error: Missing field %.*s in %.*s literal", field->name.length, field->name.data, type->name.length, type->name.data);
+        }
+    }
+    free(is_set);
+
+    return (Value){ value, type };
+}
+
+// Copied into a stack slot, for indexing an array that is only a value.
+static Place codegen_spill(CodegenContext* context, Place place) {
+    LLVMValueRef slot = codegen_entry_alloca(context, place.type, string_from_literal(""));
+    codegen_store(context, place.value, slot, type_align(context, place.type));
+    return place_in_memory(place.type, slot, type_align(context, place.type), 0);
+}
+
+static LLVMValueRef codegen_index_value(CodegenContext* context, Value index) {
+    if (index.type->kind != TypeKind_Int) {
+        sil_panic("Code Gen Error: Index must be an integer, got %.*s", index.type->name.length, index.type->name.data);
+    }
+
+    LLVMTypeRef index_type = LLVMIntPtrType(LLVMGetModuleDataLayout(context->module));
+    return LLVMBuildIntCast2(context->builder, index.llvm_value, index_type, index.type->is_signed, "");
+}
+
+// The largest value of an index that is provably never negative, from
+// constants, masks, remainders and shifts, the enclosing for loop ranges,
+// and otherwise the width of an unsigned index.
+static int codegen_index_max(CodegenContext* context, LLVMValueRef index, int is_signed, uint64_t* max) {
+    unsigned int bits = LLVMGetIntTypeWidth(LLVMTypeOf(index));
+    if (bits > 64) {
+        return 0;
+    }
+
+    if (LLVMIsAConstantInt(index)) {
+        if (is_signed && LLVMConstIntGetSExtValue(index) < 0) {
+            return 0;
+        }
+        *max = LLVMConstIntGetZExtValue(index);
+        return 1;
+    }
+
+    for (int i = context->loop_ranges.length - 1; i >= 0; i--) {
+        LoopRange* range = list_get(LoopRange, &context->loop_ranges, i);
+        if (range->counter == index && range->has_end) {
+            *max = range->end - 1;
+            return 1;
+        }
+    }
+
+    if (LLVMIsAInstruction(index)) {
+        switch (LLVMGetInstructionOpcode(index)) {
+            case LLVMAnd: {
+                // a mask bounds the result even when the other side is unknown
+                uint64_t left, right;
+                int has_left = codegen_index_max(context, LLVMGetOperand(index, 0), is_signed, &left);
+                int has_right = codegen_index_max(context, LLVMGetOperand(index, 1), is_signed, &right);
+                if (has_left || has_right) {
+                    *max = !has_right || (has_left && left < right) ? left : right;
+                    return 1;
+                }
+                break;
+            }
+            case LLVMURem: {
+                LLVMValueRef divisor = LLVMGetOperand(index, 1);
+                if (LLVMIsAConstantInt(divisor) && LLVMConstIntGetZExtValue(divisor) > 0) {
+                    *max = LLVMConstIntGetZExtValue(divisor) - 1;
+                    return 1;
+                }
+                break;
+            }
+            case LLVMLShr:
+            case LLVMAShr: {
+                // ashr of a value known not to be negative shifts in zeros.
+                // A shift by 0 leaves a signed index as negative as it was.
+                int is_arithmetic = LLVMGetInstructionOpcode(index) == LLVMAShr;
+                LLVMValueRef amount = LLVMGetOperand(index, 1);
+                uint64_t value;
+                if (LLVMIsAConstantInt(amount)
+                    && LLVMConstIntGetZExtValue(amount) != 0
+                    && LLVMConstIntGetZExtValue(amount) < bits
+                    && codegen_index_max(context, LLVMGetOperand(index, 0), is_arithmetic && is_signed, &value)) {
+                    *max = value >> LLVMConstIntGetZExtValue(amount);
+                    return 1;
+                }
+                break;
+            }
+            case LLVMZExt:
+                return codegen_index_max(context, LLVMGetOperand(index, 0), 0, max);
+            default:
+                break;
+        }
+    }
+
+    if (!is_signed) {
+        *max = bits == 64 ? UINT64_MAX : ((uint64_t)1 << bits) - 1;
+        return 1;
+    }
+    return 0;
+}
+
+// Whether a for loop over [0..s.len] or similar proves index < s.len.
+static int codegen_index_below_length(CodegenContext* context, LLVMValueRef index, LLVMValueRef slice) {
+    for (int i = context->loop_ranges.length - 1; i >= 0; i--) {
+        LoopRange* range = list_get(LoopRange, &context->loop_ranges, i);
+        if (range->counter == index && range->slice == slice) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Traps unless offset < length. The comparison is unsigned, so a negative
+// index, which converts to a huge offset, fails too.
+static void codegen_bounds_check(CodegenContext* context, LLVMValueRef offset, LLVMValueRef length) {
+    LLVMValueRef failed = LLVMBuildICmp(context->builder, LLVMIntUGE, offset, length, "");
+    codegen_trap_if(context, failed, "bounds.ok");
+}
+
+// Bounds of an array, or a slice of a string literal, are known at compile
+// time: a constant index out of bounds is an error, and other indices are
+// checked at run time unless their range proves them in bounds.
+static void codegen_fixed_bounds_check(CodegenContext* context, Type* type, uint64_t length, Value index, LLVMValueRef offset) {
+    if (LLVMIsAConstantInt(index.llvm_value)) {
+        if (index.type->is_signed && LLVMConstIntGetSExtValue(index.llvm_value) < 0) {
+            sil_panic("Code Gen Error: Negative index %lld into %.*s", LLVMConstIntGetSExtValue(index.llvm_value), type->name.length, type->name.data);
+        }
+        if (LLVMConstIntGetZExtValue(index.llvm_value) >= length) {
+            sil_panic(
+                "Code Gen Error: Index %llu out of bounds for %.*s of length %llu",
+                LLVMConstIntGetZExtValue(index.llvm_value),
+                type->name.length,
+                type->name.data,
+                (unsigned long long)length
+            );
+        }
+        return;
     }
 
-    switch (type_name->data.type_name.primitive) {
-        case AstTypeName_unreachable: return LLVMVoidType();
-        case AstTypeName_void: return LLVMVoidType();
-        case AstTypeName_i32: return LLVMInt32Type();
-        case AstTypeName_u8: return LLVMInt8Type();
-        default: sil_panic("Code Gen Error: Cannot convert sil type to LLVM type");
+    uint64_t max;
+    if (!context->options->bounds_checks || (codegen_index_max(context, index.llvm_value, index.type->is_signed, &max) && max < length)) {
+        return;
     }
+    codegen_bounds_check(context, offset, LLVMConstInt(LLVMTypeOf(offset), length, 0));
 }
 
-static LLVMValueRef codegen_expression(CodegenContext* context, AstNode* expression);
+static Value codegen_slice_value(CodegenContext* context, Type* type, LLVMValueRef pointer, LLVMValueRef length) {
+    LLVMValueRef value = LLVMGetUndef(type->llvm_type);
+    value = LLVMBuildInsertValue(context->builder, value, pointer, 0, "");
+    value = LLVMBuildInsertValue(context->builder, value, length, 1, "");
+    return (Value){ value, type };
+}
 
-static LLVMValueRef codegen_fn_call(CodegenContext* context, AstNode* fn_call) {
-    String name = fn_call->data.primary_expression.function_call.name;
+// Element index of an array in memory.
+static Place codegen_element_place(CodegenContext* context, Place array, LLVMValueRef index) {
+    Type* element = array.type->child;
+    if (array.type->is_soa) {
+        return (Place){ element, array.pointer, array.align, NULL, array.type, index, array.is_mutable };
+    }
 
-    AstNode* fn = map_get(&context->function_map, name);
-    if (fn == NULL) {
-        sil_panic("Function not defined %.*s", name.length, name.data);
+    LLVMValueRef indices[] = { LLVMConstInt(LLVMInt32Type(), 0, 0), index };
+    LLVMValueRef pointer = LLVMBuildInBoundsGEP2(context->builder, array.type->llvm_type, array.pointer, indices, 2, "");
+    unsigned int align = layout_offset_align(array.align, type_size(context, element));
+    return place_in_memory(element, pointer, align, array.is_mutable);
+}
+
+// A field of a @soa element is one element of that field's column.
+static Place codegen_soa_field_place(CodegenContext* context, Place element, StructField* field) {
+    StructField* column = type_field(element.soa, field->name);
+    LLVMValueRef indices[] = {
+        LLVMConstInt(LLVMInt32Type(), 0, 0),
+        LLVMConstInt(LLVMInt32Type(), column->index, 0),
+        element.soa_index,
+    };
+    LLVMValueRef pointer = LLVMBuildInBoundsGEP2(context->builder, element.soa->llvm_type, element.pointer, indices, 3, field->name.data);
+
+    unsigned int align = layout_offset_align(element.align, column->offset);
+    align = layout_offset_align(align, type_size(context, field->type));
+    return place_in_memory(field->type, pointer, align, element.is_mutable);
+}
+
+// A slice of the whole array; only a mutable array gives a mutable slice.
+static Value codegen_array_as_slice(CodegenContext* context, Place array, Type* slice) {
+    if (!slice->is_const && !array.is_mutable) {
+        sil_panic(
+            "Code Gen Error: Cannot take %.*s of an immutable %.*s",
+            slice->name.length,
+            slice->name.data,
+            array.type->name.length,
+            array.type->name.data
+        );
+    }
+    if (array.pointer == NULL) {
+        array = codegen_spill(context, array);
     }
 
-    LLVMValueRef fn_ref = LLVMGetNamedFunction(context->module, name.data);
-    AstNode* fn_proto = fn->data.fn.prototype;
+    LLVMTypeRef index_type = LLVMIntPtrType(LLVMGetModuleDataLayout(context->module));
+    Place first = codegen_element_place(context, array, LLVMConstInt(index_type, 0, 0));
+    return codegen_slice_value(context, slice, first.pointer, LLVMConstInt(index_type, array.type->length, 0));
+}
 
-    List* parameter_list = &fn_call->data.primary_expression.function_call.parameters;
-    int param_count = fn_call->data.primary_expression.function_call.parameters.length;
-    if (param_count != fn->data.fn.prototype->data.fn_proto.parameters.length) {
-        sil_panic("Wrong number of arguments");
+static Place codegen_place(CodegenContext* context, AstNode* expression);
+static Value codegen_place_load(CodegenContext* context, Place place);
+
+// value[start..end] of an array or a slice, pointing into the same elements.
+static Value codegen_slice(CodegenContext* context, AstNode* expression) {
+    AstNodeIndex* slice = &expression->data.index;
+    LLVMBuilderRef builder = context->builder;
+    Place base = codegen_place(context, slice->value);
+
+    int is_array = base.type->kind == TypeKind_Array && !base.type->is_soa;
+    if (!is_array && base.type->kind != TypeKind_Slice) {
+        sil_panic("Code Gen Error: Cannot slice %.*s", base.type->name.length, base.type->name.data);
+    }
+    if (is_array && base.pointer == NULL) {
+        base = codegen_spill(context, base);
     }
 
-    LLVMValueRef* parameters = malloc(sizeof(LLVMValueRef) * param_count);
-    for (int i = 0; i < param_count; i++) {
-        parameters[i] = codegen_expression(context, *list_get(AstNode*, parameter_list, i));
+    LLVMValueRef base_value = is_array ? NULL : codegen_place_load(context, base).llvm_value;
+    Value start = codegen_expression(context, slice->index, NULL);
+    Value end = codegen_expression(context, slice->end, NULL);
+    LLVMValueRef first = codegen_index_value(context, start);
+    LLVMValueRef last = codegen_index_value(context, end);
+
+    Type* element = base.type->child;
+    LLVMValueRef pointer, length;
+    if (is_array) {
+        pointer = codegen_element_place(context, base, first).pointer;
+        length = LLVMConstInt(LLVMTypeOf(first), base.type->length, 0);
+    } else {
+        pointer = LLVMBuildExtractValue(builder, base_value, 0, "");
+        pointer = LLVMBuildInBoundsGEP2(builder, element->llvm_type, pointer, &first, 1, "");
+        length = LLVMBuildExtractValue(builder, base_value, 1, "");
     }
 
+    // start <= end <= length; constants fold, so bounds wrong at compile
+    // time are an error whatever the mode
+    uint64_t max;
+    int end_in_bounds = is_array && codegen_index_max(context, end.llvm_value, end.type->is_signed, &max) && max <= base.type->length;
+    LLVMValueRef failed = LLVMBuildICmp(builder, LLVMIntUGT, first, last, "");
+    if (!end_in_bounds) {
+        failed = LLVMBuildOr(builder, failed, LLVMBuildICmp(builder, LLVMIntUGT, last, length, ""), "");
+    }
+    if (LLVMIsAConstantInt(failed)) {
+        if (LLVMConstIntGetZExtValue(failed)) {
+            sil_panic("Code Gen Error: Slice out of bounds for %.*s", base.type->name.length, base.type->name.data);
+        }
+    } else if (context->options->bounds_checks) {
+        codegen_trap_if(context, failed, "bounds.ok");
+    }
 
-    LLVMValueRef call_ref = LLVMBuildCall2(
-        context->builder,
-        fn_proto->data.fn_proto.llvm_fn_type,
-        fn_ref,
-        parameters,
-        param_count,
-        ""
-    );
+    Type* type = type_slice(context, element, is_array ? !base.is_mutable : base.type->is_const);
+    return codegen_slice_value(context, type, pointer, LLVMBuildSub(builder, last, first, ""));
+}
 
-    free(parameters);
+static Place codegen_field_place(CodegenContext* context, AstNode* expression) {
+    String name = expression->data.field_access.field;
+    Place base = codegen_place(context, expression->data.field_access.value);
+
+    // an array knows its length; a slice carries it beside its data pointer
+    if (base.type->kind == TypeKind_Array && string_compare(name, string_from_literal("len"))) {
+        Type* usize = type_usize(context);
+        return place_of_value((Value){ LLVMConstInt(usize->llvm_type, base.type->length, 0), usize });
+    }
+    if (base.type->kind == TypeKind_Slice) {
+        LLVMValueRef slice = codegen_place_load(context, base).llvm_value;
+        if (string_compare(name, string_from_literal("len"))) {
+            return place_of_value((Value){ LLVMBuildExtractValue(context->builder, slice, 1, "len"), type_usize(context) });
+        }
+        if (string_compare(name, string_from_literal("ptr"))) {
+            Type* pointer = type_pointer(context, base.type->child);
+            return place_of_value((Value){ LLVMBuildExtractValue(context->builder, slice, 0, "ptr"), pointer });
+        }
+    }
+
+    // a pointer to a struct reaches its fields without dereferencing
+    if (base.type->kind == TypeKind_Pointer && base.type->child->kind == TypeKind_Struct) {
+        LLVMValueRef pointer = base.pointer != NULL
+            ? codegen_load(context, base.type, base.pointer, base.align)
+            : base.value;
+        Type* type = base.type->child;
+        base = place_in_memory(type, pointer, type_align(context, type), 1);
+    }
+
+    if (base.type->kind != TypeKind_Struct) {
+        sil_panic("Code Gen Error: %.*s has no field %.*s", base.type->name.length, base.type->name.data, name.length, name.data);
+    }
+
+    StructField* field = type_field(base.type, name);
+    if (field == NULL) {
+        sil_panic("Code Gen Error: %.*s has no field %.*s", base.type->name.length, base.type->name.data, name.length, name.data);
+    }
 
-    return call_ref;
+    if (base.soa != NULL) {
+        return codegen_soa_field_place(context, base, field);
+    }
+
+    if (base.pointer == NULL) {
+        LLVMValueRef value = LLVMBuildExtractValue(context->builder, base.value, field->index, "");
+        return place_of_value((Value){ value, field->type });
+    }
+
+    LLVMValueRef pointer = LLVMBuildStructGEP2(context->builder, base.type->llvm_type, base.pointer, field->index, name.data);
+    return place_in_memory(field->type, pointer, layout_offset_align(base.align, field->offset), base.is_mutable);
 }
 
-static LLVMValueRef codegen_primary_expression(CodegenContext* context, AstNode* primary) {
-    switch (primary->data.primary_expression.type) {
-        case PrimaryExpressionType_Number:  {
-            String number_text = primary->data.primary_expression.number;
-            return LLVMConstIntOfStringAndSize(LLVMInt32Type(), number_text.data, number_text.length, 10);
-        }
-        case PrimaryExpressionType_String: {
-            String string_text = primary->data.primary_expression.string;
-            LLVMValueRef string_global = LLVMBuildGlobalString(context->builder, string_text.data, "");
-            return LLVMBuildPointerCast(
-                context->builder,
-                string_global,
-                LLVMPointerType(LLVMInt8Type(), 0),
-                ""
-            );
+static Place codegen_index_place(CodegenContext* context, AstNode* expression) {
+    if (expression->data.index.end != NULL) {
+        return place_of_value(codegen_slice(context, expression));
+    }
+
+    Place base = codegen_place(context, expression->data.index.value);
+    if (base.type->kind == TypeKind_Slice) {
+        Value slice = codegen_place_load(context, base);
+        Value index = codegen_expression(context, expression->data.index.index, NULL);
+        LLVMValueRef offset = codegen_index_value(context, index);
+
+        // a loop bounded by the length of this very slice needs no check
+        LLVMValueRef length = LLVMBuildExtractValue(context->builder, slice.llvm_value, 1, "");
+        if (LLVMIsAConstantInt(length)) {
+            codegen_fixed_bounds_check(context, base.type, LLVMConstIntGetZExtValue(length), index, offset);
+        } else if (context->options->bounds_checks && !codegen_index_below_length(context, index.llvm_value, slice.llvm_value)) {
+            codegen_bounds_check(context, offset, length);
         }
 
-        case PrimaryExpressionType_Symbol:
-            return codegen_fn_call(context, primary);
+        Type* element = base.type->child;
+        LLVMValueRef data = LLVMBuildExtractValue(context->builder, slice.llvm_value, 0, "");
+        LLVMValueRef pointer = LLVMBuildInBoundsGEP2(context->builder, element->llvm_type, data, &offset, 1, "");
+        return place_in_memory(element, pointer, type_align(context, element), !base.type->is_const);
+    }
+
+    if (base.type->kind != TypeKind_Array) {
+        sil_panic("Code Gen Error: Cannot index %.*s", base.type->name.length, base.type->name.data);
+    }
+    if (base.pointer == NULL) {
+        base = codegen_spill(context, base);
+    }
+
+    Value index = codegen_expression(context, expression->data.index.index, NULL);
+    LLVMValueRef offset = codegen_index_value(context, index);
+    codegen_fixed_bounds_check(context, base.type, base.type->length, index, offset);
+    return codegen_element_place(context, base, offset);
+}
+
+static int codegen_is_place(AstNode* expression) {
+    switch (expression->type) {
+        case AstNodeType_PrimaryExpression:
+            return expression->data.primary_expression.type == PrimaryExpressionType_Variable;
+        case AstNodeType_FieldAccess:
+            return 1;
+        case AstNodeType_Index:
+            return expression->data.index.end == NULL;
         default:
-            sil_panic("Code Gen Error: Unhandled primary expression");
+            return 0;
     }
 }
 
-static LLVMValueRef codegen_expression(CodegenContext* context, AstNode* expression) {
+// Locals in memory, and fields and elements reached through them, stay in
+// memory, so p.x or a[i] loads or stores one element instead of the whole.
+static Place codegen_place(CodegenContext* context, AstNode* expression) {
     switch (expression->type) {
         case AstNodeType_PrimaryExpression:
-            return codegen_primary_expression(context, expression);
+            if (expression->data.primary_expression.type == PrimaryExpressionType_Variable) {
+                PrimaryExpressionVariable* variable = &expression->data.primary_expression.variable;
+                Local local = codegen_find_local(context, variable->name, variable->symbol);
+                if (local.in_memory) {
+                    Type* type = local.value.type;
+                    return place_in_memory(type, local.value.llvm_value, type_align(context, type), local.is_mutable);
+                }
+                return place_of_value(local.value);
+            }
+            break;
+        case AstNodeType_FieldAccess:
+            return codegen_field_place(context, expression);
+        case AstNodeType_Index:
+            return codegen_index_place(context, expression);
+        default:
+            break;
+    }
 
-        case AstNodeType_UnaryOperator: {
-            LLVMValueRef value = codegen_expression(
-                context,
-                expression->data.unary_operator.value
-            );
+    return place_of_value(codegen_expression(context, expression, NULL));
+}
 
-            switch (expression->data.unary_operator.type) {
-                case UnaryOperatorType_Negation:
-                    return LLVMBuildNeg(context->builder, value, "");
-                default:
-                    sil_panic("Code Gen Error: Unhandled unary operator");
-            }
+static Value codegen_place_load(CodegenContext* context, Place place) {
+    // a @soa element is gathered from its columns
+    if (place.soa != NULL) {
+        LLVMValueRef value = LLVMConstNull(place.type->llvm_type);
+        for (int i = 0; i < place.type->fields.length; i++) {
+            StructField* field = list_get(StructField, &place.type->fields, i);
+            Place column = codegen_soa_field_place(context, place, field);
+            LLVMValueRef field_value = codegen_load(context, field->type, column.pointer, column.align);
+            value = LLVMBuildInsertValue(context->builder, value, field_value, field->index, "");
         }
-        case AstNodeType_BinaryOperator: {
-            LLVMValueRef left = codegen_expression(
-                context,
-                expression->data.binary_operator.left
-            );
-            LLVMValueRef right = codegen_expression(
-                context,
-                expression->data.binary_operator.right
-            );
+        return (Value){ value, place.type };
+    }
 
-            switch (expression->data.binary_operator.type) {
-                case BinaryOperatorType_Addition:
-                    return LLVMBuildAdd(context->builder, left, right, "");
-                case BinaryOperatorType_Subtraction:
-                    return LLVMBuildSub(context->builder, left, right, "");
-                case BinaryOperatorType_Multiplication:
-                    return LLVMBuildMul(context->builder, left, right, "");
-                case BinaryOperatorType_Division:
-                    return LLVMBuildSDiv(context->builder, left, right, "");
-                default:
-                    sil_panic("Code Gen Error: Unhandled infix operator");
-            }
+    if (place.pointer == NULL) {
+        return (Value){ place.value, place.type };
+    }
+    return (Value){ codegen_load(context, place.type, place.pointer, place.align), place.type };
+}
+
+static void codegen_place_store(CodegenContext* context, Place place, Value value) {
+    if (place.soa != NULL) {
+        for (int i = 0; i < place.type->fields.length; i++) {
+            StructField* field = list_get(StructField, &place.type->fields, i);
+            Place column = codegen_soa_field_place(context, place, field);
+            LLVMValueRef field_value = LLVMBuildExtractValue(context->builder, value.llvm_value, field->index, "");
+            codegen_store(context, field_value, column.pointer, column.align);
+        }
+        return;
+    }
+
+    codegen_store(context, value.llvm_value, place.pointer, place.align);
+}
+
+// [value; count] stores value in a loop, or clears the array with a memset
+// when value is zero.
+static void codegen_fill(CodegenContext* context, Place array, Value value) {
+    LLVMBuilderRef builder = context->builder;
+    LLVMTypeRef index_type = LLVMIntPtrType(LLVMGetModuleDataLayout(context->module));
+
+    if (LLVMIsNull(value.llvm_value)) {
+        LLVMValueRef size = LLVMConstInt(index_type, type_size(context, array.type), 0);
+        LLVMBuildMemSet(builder, array.pointer, LLVMConstInt(LLVMInt8Type(), 0, 0), size, array.align);
+        return;
+    }
+
+    LLVMBasicBlockRef entry_block = LLVMGetInsertBlock(builder);
+    LLVMBasicBlockRef fill_block = LLVMAppendBasicBlock(context->current_function, "fill");
+    LLVMBasicBlockRef end_block = LLVMAppendBasicBlock(context->current_function, "fill.end");
+    LLVMBuildBr(builder, fill_block);
+
+    LLVMPositionBuilderAtEnd(builder, fill_block);
+    LLVMValueRef index = LLVMBuildPhi(builder, index_type, "");
+    codegen_place_store(context, codegen_element_place(context, array, index), value);
+
+    LLVMValueRef next = LLVMBuildNUWAdd(builder, index, LLVMConstInt(index_type, 1, 0), "");
+    LLVMValueRef done = LLVMBuildICmp(builder, LLVMIntEQ, next, LLVMConstInt(index_type, array.type->length, 0), "");
+    LLVMBuildCondBr(builder, done, end_block, fill_block);
+
+    LLVMValueRef incoming[] = { LLVMConstInt(index_type, 0, 0), next };
+    LLVMBasicBlockRef blocks[] = { entry_block, fill_block };
+    LLVMAddIncoming(index, incoming, blocks, 2);
+
+    LLVMPositionBuilderAtEnd(builder, end_block);
+}
+
+static void codegen_init(CodegenContext* context, Place place, AstNode* expression);
+
+// Writes an array literal straight into memory; first is the first element
+// when the caller generated it already to learn the element type.
+static void codegen_array_literal_init(CodegenContext* context, Place array, AstNode* expression, Value* first) {
+    AstNodeArrayLiteral* literal = &expression->data.array_literal;
+    Type* element = array.type->child;
+
+    unsigned int count = literal->is_repeat ? literal->count : literal->elements.length;
+    if (count != array.type->length) {
+        sil_panic("Code Gen Error: Expected %u array elements, got %u", array.type->length, count);
+    }
+
+    if (literal->is_repeat) {
+        Value value = first != NULL ? *first : codegen_expression(context, *list_get(AstNode*, &literal->elements, 0), element);
+        codegen_fill(context, array, codegen_coerce(context, value, element));
+        return;
+    }
+
+    LLVMTypeRef index_type = LLVMIntPtrType(LLVMGetModuleDataLayout(context->module));
+    for (int i = 0; i < literal->elements.length; i++) {
+        Place slot = codegen_element_place(context, array, LLVMConstInt(index_type, i, 0));
+        if (i == 0 && first != NULL) {
+            codegen_place_store(context, slot, codegen_coerce(context, *first, element));
+        } else {
+            codegen_init(context, slot, *list_get(AstNode*, &literal->elements, i));
+        }
+    }
+}
+
+// An array literal outside an initializer is built in a temporary.
+static Value codegen_array_literal(CodegenContext* context, AstNode* expression, Type* expected) {
+    AstNodeArrayLiteral* literal = &expression->data.array_literal;
+
+    // a literal passed as a slice is built in a temporary array
+    Type* slice = NULL;
+    Type* type = expected;
+    if (expected != NULL && expected->kind == TypeKind_Slice) {
+        slice = expected;
+        unsigned int count = literal->is_repeat ? literal->count : literal->elements.length;
+        type = type_array(context, expected->child, count, 0);
+    }
+
+    Value first;
+    Value* first_value = NULL;
+    if (type == NULL || type->kind != TypeKind_Array) {
+        first = codegen_expression(context, *list_get(AstNode*, &literal->elements, 0), NULL);
+        first_value = &first;
+        unsigned int count = literal->is_repeat ? literal->count : literal->elements.length;
+        type = type_array(context, first.type, count, 0);
+    }
+
+    LLVMValueRef slot = codegen_entry_alloca(context, type, string_from_literal(""));
+    Place array = place_in_memory(type, slot, type_align(context, type), 1);
+    codegen_array_literal_init(context, array, expression, first_value);
+
+    if (slice != NULL) {
+        return codegen_array_as_slice(context, array, slice);
+    }
+    return codegen_place_load(context, array);
+}
+
+// Stores an expression's value at place, filling arrays from a literal in
+// place instead of building the whole array as a value first.
+static void codegen_init(CodegenContext* context, Place place, AstNode* expression) {
+    if (expression->type == AstNodeType_ArrayLiteral && place.type->kind == TypeKind_Array) {
+        codegen_array_literal_init(context, place, expression, NULL);
+        return;
+    }
+
+    Value value = codegen_expression(context, expression, place.type);
+    codegen_place_store(context, place, codegen_coerce(context, value, place.type));
+}
+
+// expected is a hint for untyped literals; callers coerce the result
+Value codegen_expression(CodegenContext* context, AstNode* expression, Type* expected) {
+    // an array where a slice is expected becomes a slice of itself
+    if (expected != NULL && expected->kind == TypeKind_Slice && codegen_is_place(expression)) {
+        Place place = codegen_place(context, expression);
+        if (place.type->kind == TypeKind_Array && !place.type->is_soa && place.type->child == expected->child) {
+            return codegen_array_as_slice(context, place, expected);
         }
+        return codegen_place_load(context, place);
+    }
+
+    switch (expression->type) {
+        case AstNodeType_PrimaryExpression:
+            return codegen_primary_expression(context, expression, expected);
+        case AstNodeType_UnaryOperator:
+            return codegen_unary_operator(context, expression, expected);
+        case AstNodeType_BinaryOperator:
+            return codegen_binary_operator(context, expression, expected);
+        case AstNodeType_IfExpression:
+            return codegen_if(context, expression, expected);
+        case AstNodeType_Asm:
+            return codegen_asm(context, expression);
+        case AstNodeType_StructLiteral:
+            return codegen_struct_literal(context, expression);
+        case AstNodeType_FieldAccess:
+        case AstNodeType_Index:
+            return codegen_place_load(context, codegen_place(context, expression));
+        case AstNodeType_ArrayLiteral:
+            return codegen_array_literal(context, expression, expected);
         default:
             sil_panic("Code Gen Error: Invalid expression");
     }
 }
 
+static int codegen_type_has_pointer(LLVMTypeRef type) {
+    switch (LLVMGetTypeKind(type)) {
+        case LLVMPointerTypeKind:
+            return 1;
+        case LLVMArrayTypeKind:
+        case LLVMVectorTypeKind:
+            return codegen_type_has_pointer(LLVMGetElementType(type));
+        case LLVMStructTypeKind:
+            for (unsigned int i = 0; i < LLVMCountStructElementTypes(type); i++) {
+                if (codegen_type_has_pointer(LLVMStructGetTypeAtIndex(type, i))) {
+                    return 1;
+                }
+            }
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+static int codegen_uses_frame(LLVMValueRef value, List* visited);
+
+// Whether anything stored into the memory at pointer may point into the frame.
+static int codegen_frame_stores(LLVMValueRef pointer, List* visited) {
+    LLVMUseRef use = LLVMGetFirstUse(pointer);
+    for (; use != NULL; use = LLVMGetNextUse(use)) {
+        LLVMValueRef user = LLVMGetUser(use);
+        if (LLVMIsAStoreInst(user) != NULL) {
+            if (LLVMGetOperand(user, 1) == pointer && codegen_uses_frame(LLVMGetOperand(user, 0), visited)) {
+                return 1;
+            }
+        } else if (LLVMIsAGetElementPtrInst(user) != NULL || LLVMIsACastInst(user) != NULL) {
+            if (codegen_frame_stores(user, visited)) {
+                return 1;
+            }
+        } else if (LLVMIsACallInst(user) != NULL) {
+            // a callee may store any of its arguments there
+            for (int i = 0; i < LLVMGetNumArgOperands(user); i++) {
+                if (LLVMGetOperand(user, i) != pointer && codegen_uses_frame(LLVMGetOperand(user, i), visited)) {
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// Whether a value may hold an address in the current function's frame: a
+// local, a slice of a local array or a spilled temporary, directly or
+// through a local it was stored in. Each value is followed once, which
+// also ends the search around loops.
+static int codegen_uses_frame(LLVMValueRef value, List* visited) {
+    if (!codegen_type_has_pointer(LLVMTypeOf(value))) {
+        return 0;
+    }
+    for (size_t i = 0; i < visited->length; i++) {
+        if (*list_get(LLVMValueRef, visited, i) == value) {
+            return 0;
+        }
+    }
+    list_push(LLVMValueRef, visited, &value);
+
+    if (codegen_frame_alloca(value) != NULL) {
+        return 1;
+    }
+    if (LLVMIsALoadInst(value) != NULL) {
+        LLVMValueRef slot = codegen_frame_alloca(LLVMGetOperand(value, 0));
+        return slot != NULL && codegen_frame_stores(slot, visited);
+    }
+
+    int operand_count = 0;
+    if (LLVMIsAGetElementPtrInst(value) != NULL || LLVMIsACastInst(value) != NULL
+        || LLVMIsAExtractValueInst(value) != NULL || LLVMIsAInsertValueInst(value) != NULL
+        || LLVMIsASelectInst(value) != NULL || LLVMIsAPHINode(value) != NULL) {
+        operand_count = LLVMGetNumOperands(value);
+    } else if (LLVMIsACallInst(value) != NULL) {
+        // a returned pointer can only be one of the arguments
+        operand_count = LLVMGetNumArgOperands(value);
+    }
+
+    for (int i = 0; i < operand_count; i++) {
+        if (codegen_uses_frame(LLVMGetOperand(value, i), visited)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// return tail f(x) has to jump to f in place of returning, so anything
+// that would keep the frame alive is a compile error.
+static void codegen_tail_return(CodegenContext* context, AstNode* expression) {
+    AstNode* caller = context->current_fn_proto;
+    String caller_name = caller->data.fn_proto.name;
+    if (expression->type != AstNodeType_PrimaryExpression
+        || expression->data.primary_expression.type != PrimaryExpressionType_Symbol
+        || expression->data.primary_expression.function_call.name.data[0] == '@') {
+        sil_panic("Code Gen Error: return tail in %.*s needs a function call", caller_name.length, caller_name.data);
+    }
+
+    Type* return_type = type_from_ast(context, caller->data.fn_proto.return_type);
+    Value result = codegen_fn_call(context, expression, return_type);
+    LLVMValueRef call = result.llvm_value;
+
+    // musttail needs the return right after the call, not unreachable
+    if (result.type->kind == TypeKind_Never) {
+        LLVMInstructionEraseFromParent(LLVMGetBasicBlockTerminator(LLVMGetInstructionParent(call)));
+    }
+
+    // the callee reuses the caller's argument and return slots; function
+    // types are uniqued, so equal signatures are the same type
+    String name = expression->data.primary_expression.function_call.name;
+    AstNode* callee = ((AstNode*)map_get(&context->function_map, name))->data.fn.prototype;
+    if (callee->data.fn_proto.llvm_fn_type != caller->data.fn_proto.llvm_fn_type) {
+        sil_panic(
+            "Code Gen Error: return tail from %.*s to %.*s needs identical parameter and return types",
+            caller_name.length,
+            caller_name.data,
+            name.length,
+            name.data
+        );
+    }
+
+    // the caller's frame is gone by the time the callee runs
+    for (int i = 0; i < LLVMGetNumArgOperands(call); i++) {
+        List visited = {0};
+        int uses_frame = codegen_uses_frame(LLVMGetOperand(call, i), &visited);
+        list_delete(&visited);
+        if (uses_frame) {
+            sil_panic(
+                "Code Gen Error: return tail from %.*s to %.*s passes memory in the frame of %.*s",
+                caller_name.length,
+                caller_name.data,
+                name.length,
+                name.data,
+                caller_name.length,
+                caller_name.data
+            );
+        }
+    }
+
+    // nothing may run between the call and the return, so the exit hook
+    // goes just before the jump
+    if (context->instrument_id != NULL) {
+        LLVMPositionBuilderBefore(context->builder, call);
+        instrument_fn_exit(context);
+        LLVMPositionBuilderAtEnd(context->builder, LLVMGetInstructionParent(call));
+    }
+
+    stack_usage_mark_tail_call(context);
+    ir_patch_mark(context, call, IrPatch_MustTail);
+
+    if (result.type->kind == TypeKind_Void || result.type->kind == TypeKind_Never) {
+        LLVMBuildRetVoid(context->builder);
+    } else {
+        LLVMBuildRet(context->builder, call);
+    }
+}
+
 static void codegen_statement(CodegenContext* context, AstNode* statement) {
     switch (statement->type) {
         case AstNodeType_StatementReturn: {
-            LLVMValueRef return_value = codegen_expression(context, statement->data.statement_return.expression);
-            LLVMBuildRet(context->builder, return_value);
+            if (statement->data.statement_return.is_tail) {
+                codegen_tail_return(context, statement->data.statement_return.expression);
+                break;
+            }
+
+            Type* return_type = type_from_ast(context, context->current_fn_proto->data.fn_proto.return_type);
+            if (return_type->kind == TypeKind_Never) {
+                String name = context->current_fn_proto->data.fn_proto.name;
+                sil_panic("Code Gen Error: %.*s returns !, so it cannot return", name.length, name.data);
+            }
+            Value return_value = codegen_expression(context, statement->data.statement_return.expression, return_type);
+            return_value = codegen_coerce(context, return_value, return_type);
+            instrument_fn_exit(context);
+            LLVMBuildRet(context->builder, return_value.llvm_value);
             break;
         } 
+        case AstNodeType_StatementLet: {
+            AstNodeStatementLet* let = &statement->data.statement_let;
+            Type* type = let->type != NULL ? type_from_ast(context, let->type) : NULL;
+
+            // a declared type lets the value, an array literal above all,
+            // be written straight into the slot
+            if (type != NULL && (let->is_mutable || type->kind == TypeKind_Array)) {
+                LLVMValueRef slot = codegen_entry_alloca(context, type, let->name);
+                codegen_init(context, place_in_memory(type, slot, type_align(context, type), 1), let->value);
+                codegen_add_local(context, let->name, let->symbol, (Value){ slot, type }, let->is_mutable, 1);
+                break;
+            }
+
+            Value value = codegen_expression(context, let->value, type);
+            if (type != NULL) {
+                value = codegen_coerce(context, value, type);
+            }
+
+            // only mutable locals and arrays need memory; the rest stay SSA values
+            int in_memory = let->is_mutable || value.type->kind == TypeKind_Array;
+            if (in_memory) {
+                LLVMValueRef slot = codegen_entry_alloca(context, value.type, let->name);
+                codegen_store(context, value.llvm_value, slot, type_align(context, value.type));
+                value.llvm_value = slot;
+            } else if (LLVMIsAInstruction(value.llvm_value) && LLVMGetValueName(value.llvm_value)[0] == 0) {
+                LLVMSetValueName2(value.llvm_value, let->name.data, let->name.length);
+            }
+
+            codegen_add_local(context, let->name, let->symbol, value, let->is_mutable, in_memory);
+            break;
+        }
+        case AstNodeType_StatementAssign: {
+            AstNodeStatementAssign* assign = &statement->data.statement_assign;
+            if (assign->target != NULL) {
+                Place place = codegen_place(context, assign->target);
+                if (!place.is_mutable) {
+                    sil_panic("Code Gen Error: Cannot assign to part of an immutable value");
+                }
+                codegen_check_pure_store(context, place.pointer);
+
+                codegen_init(context, place, assign->value);
+                break;
+            }
+
+            Local local = codegen_find_local(context, assign->name, assign->symbol);
+            if (!local.is_mutable) {
+                sil_panic("Code Gen Error: Cannot assign to immutable %.*s", assign->name.length, assign->name.data);
+            }
+
+            Type* type = local.value.type;
+            codegen_init(context, place_in_memory(type, local.value.llvm_value, type_align(context, type), 1), assign->value);
+            break;
+        }
         case AstNodeType_StatementExpression:
-            codegen_expression(context, statement->data.statement_expression.expression);
+            codegen_expression(context, statement->data.statement_expression.expression, NULL);
             break;
+        case AstNodeType_IfExpression:
+            codegen_expression(context, statement, NULL);
+            break;
+        case AstNodeType_StatementFor:
+            codegen_for(context, statement);
+            break;
+        case AstNodeType_StatementWhile:
+            codegen_while(context, statement);
+            break;
+        case AstNodeType_StatementBreak:
+        case AstNodeType_StatementContinue: {
+            if (context->loop_targets.length == 0) {
+                sil_panic("Code Gen Error: %s outside of a loop", statement->type == AstNodeType_StatementBreak ? "break" : "continue");
+            }
+
+            LoopTarget* target = list_get(LoopTarget, &context->loop_targets, context->loop_targets.length - 1);
+            if (statement->type == AstNodeType_StatementBreak) {
+                target->has_break = 1;
+                LLVMBuildBr(context->builder, target->break_block);
+            } else {
+                LLVMBuildBr(context->builder, target->continue_block);
+            }
+            break;
+        }
         default:
             sil_panic("Code Gen Error: Expected statement");
     }
 }
 
-static void codegen_block(CodegenContext* context, AstNode* block) {
+static Value codegen_block(CodegenContext* context, AstNode* block, Type* expected) {
+    scope_push(&context->symbols);
+    FloatMode float_mode = context->float_mode;
+
+    // statements after a return are unreachable and not generated
     List* statement_list = &block->data.block.statement_list;
-    for (int i = 0; i < statement_list->length; i++) {
+    for (int i = 0; i < statement_list->length && !codegen_block_terminated(context); i++) {
         AstNode* statement = *list_get(AstNode*, statement_list, i);
         codegen_statement(context, statement);
     }
+
+    Value value = codegen_void(context);
+    if (block->data.block.value != NULL && !codegen_block_terminated(context)) {
+        value = codegen_expression(context, block->data.block.value, expected);
+    }
+
+    scope_pop(&context->symbols);
+    context->float_mode = float_mode;
+
+    return value;
+}
+
+// Hot and cold code also get a section prefix, so the linker can group
+// them into .text.hot and .text.unlikely.
+static void codegen_fn_attributes(LLVMValueRef function, int attributes) {
+    static struct {
+        FnAttribute attribute;
+        char* llvm_attribute;
+    } mapping[] = {
+        { FnAttribute_Inline, "inlinehint" },
+        { FnAttribute_NoInline, "noinline" },
+        { FnAttribute_AlwaysInline, "alwaysinline" },
+        { FnAttribute_Hot, "hot" },
+        { FnAttribute_Cold, "cold" },
+        { FnAttribute_Pure, "readonly" },
+        { FnAttribute_Pure, "willreturn" },
+    };
+
+    for (int i = 0; i < sizeof(mapping) / sizeof(mapping[0]); i++) {
+        if (attributes & mapping[i].attribute) {
+            codegen_add_fn_attribute(function, mapping[i].llvm_attribute);
+        }
+    }
+
+    char* prefix = NULL;
+    if (attributes & FnAttribute_Hot) {
+        prefix = "hot";
+    } else if (attributes & FnAttribute_Cold) {
+        prefix = "unlikely";
+    }
+
+    if (prefix != NULL) {
+        LLVMContextRef llvm_context = LLVMGetGlobalContext();
+        LLVMMetadataRef operands[] = {
+            LLVMMDStringInContext2(llvm_context, "function_section_prefix", strlen("function_section_prefix")),
+            LLVMMDStringInContext2(llvm_context, prefix, strlen(prefix)),
+        };
+        LLVMMetadataRef node = LLVMMDNodeInContext2(llvm_context, operands, 2);
+        LLVMGlobalSetMetadata(function, LLVMGetMDKindID("section_prefix", strlen("section_prefix")), node);
+    }
 }
 
 static LLVMValueRef codegen_fn_proto(CodegenContext* context, AstNode* fn_proto) {
     String name = fn_proto->data.fn_proto.name;
-    LLVMTypeRef return_type = to_llvm_type(fn_proto->data.fn_proto.return_type);
+    LLVMTypeRef return_type = type_from_ast(context, fn_proto->data.fn_proto.return_type)->llvm_type;
     List* parameters = &fn_proto->data.fn_proto.parameters;
     LLVMTypeRef* param_types = malloc(sizeof(LLVMTypeRef) * parameters->length);
     for (int i = 0; i < parameters->length; i++) {
         AstNode* parameter = *list_get(AstNode*, parameters, i);
-        param_types[i] = to_llvm_type(parameter->data.pattern.type);
+        param_types[i] = type_from_ast(context, parameter->data.pattern.type)->llvm_type;
     }
     
     LLVMTypeRef function_type = LLVMFunctionType(return_type, param_types, parameters->length, 0);
     LLVMValueRef function = LLVMAddFunction(context->module, name.data, function_type);
 
+    // sil has no exceptions, so no unwind tables or personality routines
+    codegen_add_fn_attribute(function, "nounwind");
+    codegen_fn_attributes(function, fn_proto->data.fn_proto.attributes);
+
+    // a function that never returns is an exit or error path, unless it is
+    // main or marked hot
+    if (type_from_ast(context, fn_proto->data.fn_proto.return_type)->kind == TypeKind_Never) {
+        codegen_add_fn_attribute(function, "noreturn");
+        int is_main = string_compare_literal(name, "main") && name.length == 4;
+        if (!is_main && !(fn_proto->data.fn_proto.attributes & FnAttribute_Hot)) {
+            codegen_add_fn_attribute(function, "cold");
+        }
+    }
+
     fn_proto->data.fn_proto.llvm_fn_type = function_type;
 
     free(param_types);
@@ -188,16 +2342,66 @@ static void codegen_extern_fn(CodegenContext* context, AstNode* extern_fn) {
 }
 
 static void codegen_fn(CodegenContext* context, AstNode* fn) {
-    AstNode* fn_proto = fn->data.fn.prototype;
-    LLVMValueRef function = codegen_fn_proto(context, fn_proto);
+    String name = fn->data.fn.prototype->data.fn_proto.name;
+    LLVMValueRef function = LLVMGetNamedFunction(context->module, name.data);
+    context->current_fn_proto = fn->data.fn.prototype;
+    context->current_function = function;
+    context->trap_block = NULL;
+    context->float_mode = FloatMode_Strict;
 
     LLVMBasicBlockRef entry = LLVMAppendBasicBlock(function, "entry");
     LLVMPositionBuilderAtEnd(context->builder, entry);
 
-    codegen_block(context, fn->data.fn.body);
+    instrument_fn_enter(context, fn->data.fn.prototype);
+
+    scope_push(&context->symbols);
+
+    List* parameters = &fn->data.fn.prototype->data.fn_proto.parameters;
+    for (int i = 0; i < parameters->length; i++) {
+        AstNode* parameter = *list_get(AstNode*, parameters, i);
+        String parameter_name = parameter->data.pattern.name;
+        LLVMValueRef value = LLVMGetParam(function, i);
+        LLVMSetValueName2(value, parameter_name.data, parameter_name.length);
+
+        Type* type = type_from_ast(context, parameter->data.pattern.type);
+        codegen_add_local(context, parameter_name, parameter->data.pattern.symbol, (Value){ value, type }, 0, 0);
+    }
+
+    Type* return_type = type_from_ast(context, fn->data.fn.prototype->data.fn_proto.return_type);
+    Value value = codegen_block(context, fn->data.fn.body, return_type);
+    scope_pop(&context->symbols);
+
+    // falling off the end returns the body's value, or void
+    if (!codegen_block_terminated(context)) {
+        if (return_type->kind == TypeKind_Never) {
+            sil_panic("Code Gen Error: %.*s returns !, but can reach its end", name.length, name.data);
+        } else if (return_type->kind == TypeKind_Void) {
+            instrument_fn_exit(context);
+            LLVMBuildRetVoid(context->builder);
+        } else if (value.type->kind != TypeKind_Void) {
+            value = codegen_coerce(context, value, return_type);
+            instrument_fn_exit(context);
+            LLVMBuildRet(context->builder, value.llvm_value);
+        } else {
+            sil_panic("Code Gen Error: Missing return in %.*s", name.length, name.data);
+        }
+    }
+
+    if (context->trap_block != NULL) {
+        LLVMMoveBasicBlockAfter(context->trap_block, LLVMGetLastBasicBlock(function));
+    }
 }
 
 static void codegen_root(CodegenContext* context) {
+    // every struct is laid out, used or not, so layout errors and the
+    // report cover all of them
+    List* type_list = &context->current_node->data.root.type_list;
+    for (int i = 0; i < type_list->length; i++) {
+        AstNode* declaration = *list_get(AstNode*, type_list, i);
+        type_named(context, declaration->data.struct_declaration.name);
+    }
+
+    // declare every function first so bodies can call in any order
     for (int i = 0; i < context->function_map.entries.capacity; i++) {
         Entry* entry = list_get(Entry, &context->function_map.entries, i);
         if (!entry->used) {
@@ -210,27 +2414,58 @@ static void codegen_root(CodegenContext* context) {
                 codegen_extern_fn(context, node);
                 break;
             case AstNodeType_Fn:
-                codegen_fn(context, node);
+                codegen_fn_proto(context, node->data.fn.prototype);
                 break;
             default:
                 sil_panic("Code Gen Error: Unexpected Node in root");
             
         }    
     }
-    
+
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used) {
+            continue;
+        }
+
+        AstNode* node = entry->value;
+        if (node->type == AstNodeType_Fn) {
+            codegen_fn(context, node);
+        }
+    }
 }
 
-void codegen_generate(AstNode* ast) {
+void codegen_generate(AstNode* ast, CodegenOptions* options) {
     CodegenContext context = {0};
     context.current_node = ast;
+    context.options = options;
 
     context.builder = LLVMCreateBuilder();
     context.module = LLVMModuleCreateWithName("SilModule");
 
+    backend_init(&context);
+
     codegen_analyze(&context, ast);
+    scope_init(&context.symbols, ast->data.root.symbol_count);
 
     codegen_root(&context);
+    instrument_emit_table(&context);
+    // swaps the module, nothing may build IR after this
+    ir_patch_apply(&context);
 
     LLVMDumpModule(context.module);
-    // LLVMPrintModuleToFile(context.module, "hello.ll", NULL);
+
+    backend_verify(&context);
+    size_report_before(&context);
+    backend_optimize(&context);
+    size_report_after(&context);
+    backend_emit_ir(&context);
+    stack_usage_prepare(&context);
+    backend_emit(&context);
+
+    layout_report_print(&context);
+    size_report_print(&context);
+    stack_usage_print(&context);
+    mca_report_print(&context);
+    wcet_print(&context);
 }
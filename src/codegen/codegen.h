@@ -1,19 +1,107 @@
 #ifndef CODEGEN_H
 #define CODEGEN_H
 
+#include "codegen/scope.h"
+#include "codegen/type.h"
 #include "parser/parser.h"
 #include "hashmap.h"
 
+#include "llvm-c/TargetMachine.h"
+
+typedef enum OptimizationLevel {
+    OptimizationLevel_O0,
+    OptimizationLevel_O1,
+    OptimizationLevel_O2,
+    OptimizationLevel_O3,
+    OptimizationLevel_Os,
+    OptimizationLevel_Oz,
+} OptimizationLevel;
+
+// Set by @float_mode for the rest of the enclosing block.
+typedef enum FloatMode {
+    FloatMode_Strict,
+    // may reassociate, contract and assume no NaN, infinity or signed zero
+    FloatMode_Optimized,
+} FloatMode;
+
+typedef struct CodegenOptions {
+    char* output_path;
+    char* target_triple;
+    char* cpu;
+    OptimizationLevel optimization_level;
+    int profile_generate;
+    char* profile_generate_path;
+    char* profile_use_path;
+    int instrument_functions;
+    int size_report;
+    char* size_report_path;
+    int stack_usage;
+    char* mca_functions;
+    int wcet;
+    // trap on integer overflow instead of assuming it never happens
+    int overflow_checks;
+    // trap on an array or slice index out of bounds
+    int bounds_checks;
+    int layout_report;
+    // --emit-ir writes the optimized module here as text
+    char* ir_path;
+} CodegenOptions;
+
 typedef struct CodegenContext {
     LLVMModuleRef module;
     LLVMBuilderRef builder;
+    LLVMTargetMachineRef target_machine;
+    LLVMMemoryBufferRef object;
+    CodegenOptions* options;
     AstNode* current_node;
+    AstNode* current_fn_proto;
+    LLVMValueRef current_function;
+    // shared by every overflow and bounds check of the current function
+    LLVMBasicBlockRef trap_block;
+    FloatMode float_mode;
+    SymbolTable symbols;
+    List loop_targets;
+    // counters of the enclosing for loops, with the bounds their range gives
+    List loop_ranges;
+    LLVMValueRef instrument_id;
     HashMap function_map;
+    HashMap struct_map;
+    HashMap types;
+    // struct types in the order they were laid out
+    List structs;
+    List instrumented_functions;
+    List function_sizes;
+    List call_edges;
+    List stack_frames;
+    List loop_bounds;
+    size_t ir_patch_count;
 } CodegenContext;
 
 void codegen_new(void);
-void codegen_generate(AstNode* ast);
+void codegen_generate(AstNode* ast, CodegenOptions* options);
 
 void codegen_print(void);
 
+void codegen_add_fn_attribute(LLVMValueRef function, const char* name);
+
+Value codegen_expression(CodegenContext* context, AstNode* expression, Type* expected);
+// A pure function may only store into its own frame.
+void codegen_check_pure_store(CodegenContext* context, LLVMValueRef pointer);
+// widens a value to the type the surrounding code needs
+Value codegen_coerce(CodegenContext* context, Value value, Type* type);
+// every lane of the vector set to the scalar
+LLVMValueRef codegen_splat(CodegenContext* context, LLVMValueRef scalar, Type* vector);
+// Adds fast-math flags to a floating point instruction when the scope's
+// float mode is optimized.
+void codegen_float_flags(CodegenContext* context, LLVMValueRef instruction);
+// Calls an overloaded LLVM intrinsic such as llvm.vector.reduce.add.v8i16.
+LLVMValueRef codegen_intrinsic_call(
+    CodegenContext* context,
+    const char* name,
+    LLVMTypeRef* overloads,
+    size_t overload_count,
+    LLVMValueRef* arguments,
+    unsigned int argument_count
+);
+
 #endif
@@ -0,0 +1,117 @@
+#include "instrument.h"
+
+#include "codegen.h"
+#include "list.h"
+#include "string_buffer.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Target.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+static LLVMValueRef get_hook(CodegenContext* context, const char* name, LLVMTypeRef* hook_type) {
+    LLVMTypeRef param_types[] = { LLVMInt32Type() };
+    *hook_type = LLVMFunctionType(LLVMVoidType(), param_types, 1, 0);
+
+    LLVMValueRef hook = LLVMGetNamedFunction(context->module, name);
+    if (hook == NULL) {
+        hook = LLVMAddFunction(context->module, name, *hook_type);
+        codegen_add_fn_attribute(hook, "nounwind");
+    }
+
+    return hook;
+}
+
+static void build_hook_call(CodegenContext* context, const char* name) {
+    LLVMTypeRef hook_type;
+    LLVMValueRef hook = get_hook(context, name, &hook_type);
+    LLVMValueRef arguments[] = { context->instrument_id };
+    LLVMBuildCall2(context->builder, hook_type, hook, arguments, 1, "");
+}
+
+void instrument_fn_enter(CodegenContext* context, AstNode* fn_proto) {
+    context->instrument_id = NULL;
+
+    if (!context->options->instrument_functions) {
+        return;
+    }
+
+    // the hooks themselves may be written in sil, and a hook call would
+    // break the promise of a pure function
+    String name = fn_proto->data.fn_proto.name;
+    if (fn_proto->data.fn_proto.attributes & (FnAttribute_NoInstrument | FnAttribute_Pure)
+        || strncmp(name.data, "__sil_", 6) == 0) {
+        return;
+    }
+
+    // ids are name hashes so tables from several objects can be linked
+    context->instrument_id = LLVMConstInt(LLVMInt32Type(), string_hash(name), 0);
+    list_push(AstNode*, &context->instrumented_functions, &fn_proto);
+
+    build_hook_call(context, "__sil_enter");
+}
+
+void instrument_fn_exit(CodegenContext* context) {
+    if (context->instrument_id == NULL) {
+        return;
+    }
+
+    build_hook_call(context, "__sil_exit");
+}
+
+static void mark_used(CodegenContext* context, LLVMValueRef global) {
+    LLVMTypeRef pointer_type = LLVMPointerType(LLVMInt8Type(), 0);
+    LLVMValueRef used_values[] = { LLVMConstPointerCast(global, pointer_type) };
+    LLVMValueRef used_array = LLVMConstArray(pointer_type, used_values, 1);
+
+    LLVMValueRef used = LLVMAddGlobal(context->module, LLVMTypeOf(used_array), "llvm.used");
+    LLVMSetInitializer(used, used_array);
+    LLVMSetLinkage(used, LLVMAppendingLinkage);
+    LLVMSetSection(used, "llvm.metadata");
+}
+
+void instrument_emit_table(CodegenContext* context) {
+    List* functions = &context->instrumented_functions;
+    if (functions->length == 0) {
+        return;
+    }
+
+    LLVMTypeRef pointer_type = LLVMPointerType(LLVMInt8Type(), 0);
+    LLVMTypeRef entry_fields[] = { LLVMInt32Type(), pointer_type };
+    LLVMTypeRef entry_type = LLVMStructType(entry_fields, 2, 0);
+
+    LLVMValueRef* entries = malloc(sizeof(LLVMValueRef) * functions->length);
+    for (int i = 0; i < functions->length; i++) {
+        AstNode* fn_proto = *list_get(AstNode*, functions, i);
+        String name = fn_proto->data.fn_proto.name;
+
+        LLVMValueRef name_constant = LLVMConstString(name.data, name.length, 0);
+        LLVMValueRef name_global = LLVMAddGlobal(context->module, LLVMTypeOf(name_constant), "");
+        LLVMSetInitializer(name_global, name_constant);
+        LLVMSetGlobalConstant(name_global, 1);
+        LLVMSetLinkage(name_global, LLVMPrivateLinkage);
+        LLVMSetUnnamedAddress(name_global, LLVMGlobalUnnamedAddr);
+
+        LLVMValueRef fields[] = {
+            LLVMConstInt(LLVMInt32Type(), string_hash(name), 0),
+            LLVMConstPointerCast(name_global, pointer_type),
+        };
+        entries[i] = LLVMConstNamedStruct(entry_type, fields, 2);
+    }
+
+    LLVMValueRef table_constant = LLVMConstArray(entry_type, entries, functions->length);
+    LLVMValueRef table = LLVMAddGlobal(context->module, LLVMTypeOf(table_constant), "__sil_fn_names");
+    LLVMSetInitializer(table, table_constant);
+    LLVMSetGlobalConstant(table, 1);
+    LLVMSetLinkage(table, LLVMInternalLinkage);
+    LLVMSetSection(table, "sil_fn_names");
+
+    // tables of several objects are concatenated, so entries must not need padding
+    LLVMTargetDataRef data_layout = LLVMGetModuleDataLayout(context->module);
+    LLVMSetAlignment(table, LLVMABIAlignmentOfType(data_layout, entry_type));
+
+    mark_used(context, table);
+
+    free(entries);
+}
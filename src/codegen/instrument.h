@@ -0,0 +1,17 @@
+#ifndef CODEGEN_INSTRUMENT_H
+#define CODEGEN_INSTRUMENT_H
+
+#include "parser/parser.h"
+
+typedef struct CodegenContext CodegenContext;
+
+// Calls __sil_enter(fn_id) at the start of the current function.
+void instrument_fn_enter(CodegenContext* context, AstNode* fn_proto);
+
+// Calls __sil_exit(fn_id). Has to be emitted before every return.
+void instrument_fn_exit(CodegenContext* context);
+
+// Emits the fn_id to name table into the sil_fn_names section.
+void instrument_emit_table(CodegenContext* context);
+
+#endif
@@ -0,0 +1,169 @@
+#include "ir_patch.h"
+
+#include "codegen.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/IRReader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char* patch_kinds[] = {
+    [IrPatch_MustTail] = "sil.musttail",
+    [IrPatch_FastMath] = "sil.fast",
+};
+
+#define FAST_MATH_FLAGS "reassoc nnan ninf nsz arcp contract "
+
+void ir_patch_mark(CodegenContext* context, LLVMValueRef instruction, IrPatch patch) {
+    if (patch == IrPatch_MustTail) {
+        LLVMSetTailCall(instruction, 1);
+    }
+
+    const char* kind = patch_kinds[patch];
+    LLVMContextRef llvm_context = LLVMGetGlobalContext();
+    LLVMMetadataRef node = LLVMMDNodeInContext2(llvm_context, NULL, 0);
+    LLVMSetMetadata(instruction, LLVMGetMDKindID(kind, strlen(kind)), LLVMMetadataAsValue(llvm_context, node));
+
+    context->ir_patch_count += 1;
+}
+
+// Metadata attachments end an instruction line: ", !sil.fast !3" and the
+// like, after every operand, so text in a string operand never matches.
+static int line_has_marker(const char* line, const char* end, IrPatch patch) {
+    if (end > line && end[-1] == '\n') {
+        end--;
+    }
+
+    const char* kind = patch_kinds[patch];
+    for (;;) {
+        // the node id
+        const char* c = end;
+        while (c > line && c[-1] >= '0' && c[-1] <= '9') {
+            c--;
+        }
+        if (c == end || c - line < 2 || c[-1] != '!' || c[-2] != ' ') {
+            return 0;
+        }
+        c -= 2;
+
+        // the kind name
+        const char* name_end = c;
+        while (c > line && c[-1] != '!' && c[-1] != ' ') {
+            c--;
+        }
+        if (c - line < 3 || strncmp(c - 3, ", !", 3) != 0) {
+            return 0;
+        }
+        if ((size_t)(name_end - c) == strlen(kind) && strncmp(c, kind, name_end - c) == 0) {
+            return 1;
+        }
+        end = c - 3;
+    }
+}
+
+// Where the patch text goes: before "tail call" for musttail, and after
+// the opcode ("fadd", "fcmp", "call") for fast-math flags.
+static const char* patch_position(const char* line, const char* end, IrPatch patch) {
+    const char* c = line;
+    while (c < end && *c == ' ') {
+        c++;
+    }
+
+    // skip "%name = "
+    const char* assignment = strstr(c, " = ");
+    if (assignment != NULL && assignment < end) {
+        c = assignment + strlen(" = ");
+    }
+
+    if (patch == IrPatch_MustTail) {
+        return strncmp(c, "tail call ", strlen("tail call ")) == 0 ? c : NULL;
+    }
+
+    if (strncmp(c, "tail ", strlen("tail ")) == 0) {
+        c += strlen("tail ");
+    }
+    const char* opcode_end = strchr(c, ' ');
+    return opcode_end != NULL && opcode_end < end ? opcode_end + 1 : NULL;
+}
+
+static char* apply_patches(const char* ir, size_t count, size_t* applied) {
+    static const char* texts[] = {
+        [IrPatch_MustTail] = "must",
+        [IrPatch_FastMath] = FAST_MATH_FLAGS,
+    };
+
+    char* result = malloc(strlen(ir) + strlen(FAST_MATH_FLAGS) * count + 1);
+    char* out = result;
+
+    int in_body = 0;
+    for (const char* line = ir; *line != 0;) {
+        const char* end = strchr(line, '\n');
+        end = end != NULL ? end + 1 : line + strlen(line);
+
+        // instructions are the indented lines between "define ... {" and "}"
+        if (strncmp(line, "define ", strlen("define ")) == 0) {
+            in_body = 1;
+        } else if (*line == '}') {
+            in_body = 0;
+        }
+
+        // the musttail position comes before the fast-math one on a call
+        const char* start = line;
+        for (IrPatch patch = IrPatch_MustTail; in_body && *start == ' ' && patch <= IrPatch_FastMath; patch++) {
+            const char* position = line_has_marker(start, end, patch) ? patch_position(line, end, patch) : NULL;
+            if (position != NULL) {
+                memcpy(out, line, position - line);
+                out += position - line;
+                memcpy(out, texts[patch], strlen(texts[patch]));
+                out += strlen(texts[patch]);
+                line = position;
+                *applied += 1;
+            }
+        }
+
+        memcpy(out, line, end - line);
+        out += end - line;
+        line = end;
+    }
+
+    *out = 0;
+    return result;
+}
+
+void ir_patch_apply(CodegenContext* context) {
+    if (context->ir_patch_count == 0) {
+        return;
+    }
+
+    char* ir = LLVMPrintModuleToString(context->module);
+    size_t applied = 0;
+    char* patched = apply_patches(ir, context->ir_patch_count, &applied);
+    LLVMDisposeMessage(ir);
+
+    // every marked instruction prints as one line with its marker; anything
+    // else means the printer's format is not the one patch_position expects
+    if (applied != context->ir_patch_count) {
+        sil_panic("Code Gen Error: Patched %zu of %zu marked instructions", applied, context->ir_patch_count);
+    }
+
+    // the parser takes ownership of the buffer
+    LLVMMemoryBufferRef buffer = LLVMCreateMemoryBufferWithMemoryRangeCopy(patched, strlen(patched), "sil");
+    free(patched);
+
+    LLVMModuleRef module;
+    char* error;
+    if (LLVMParseIRInContext(LLVMGetGlobalContext(), buffer, &module, &error)) {
+        sil_panic("Code Gen Error: Could not patch the IR\n%s", error);
+    }
+
+    LLVMDisposeModule(context->module);
+    context->module = module;
+
+    // values and blocks of the old module are gone with it
+    LLVMClearInsertionPosition(context->builder);
+    context->current_function = NULL;
+    context->trap_block = NULL;
+}
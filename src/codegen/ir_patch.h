@@ -0,0 +1,27 @@
+#ifndef CODEGEN_IR_PATCH_H
+#define CODEGEN_IR_PATCH_H
+
+#include "llvm-c/Types.h"
+
+typedef struct CodegenContext CodegenContext;
+
+// Instruction properties the C api cannot set.
+typedef enum IrPatch {
+    // a tail call that must be lowered as musttail; it has to be followed
+    // directly by the return of its value
+    IrPatch_MustTail,
+    // reassoc nnan ninf nsz arcp contract on a floating point operation
+    IrPatch_FastMath,
+} IrPatch;
+
+void ir_patch_mark(CodegenContext* context, LLVMValueRef instruction, IrPatch patch);
+
+// Marked instructions are tagged with metadata and patched by one round
+// trip through the textual IR. This replaces context->module and clears
+// every value the context held into the old one, so it has to be the last
+// step that builds IR: codegen_generate calls it once, after the instrument
+// table and before verification. Passes after it look functions up by name.
+// Panics when a marked instruction could not be found in the printed IR.
+void ir_patch_apply(CodegenContext* context);
+
+#endif
@@ -0,0 +1,268 @@
+#include "layout.h"
+
+#include "codegen.h"
+#include "hashmap.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Target.h"
+#include "llvm-c/TargetMachine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static uint64_t align_up(uint64_t offset, unsigned int align) {
+    return (offset + align - 1) / align * align;
+}
+
+unsigned int layout_cacheline_size(CodegenContext* context) {
+    // Cortex-M7 and the 32-bit A cores fill 32 byte lines, the rest 64
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    unsigned int size = 64;
+    if (strncmp(triple, "arm", 3) == 0 || strncmp(triple, "thumb", 5) == 0) {
+        size = 32;
+    }
+    LLVMDisposeMessage(triple);
+
+    return size;
+}
+
+unsigned int layout_offset_align(unsigned int align, uint64_t offset) {
+    // the lowest set bit of the offset is the largest power of two dividing it
+    while (offset % align != 0) {
+        align /= 2;
+    }
+
+    return align;
+}
+
+static void add_padding(List* elements, uint64_t bytes) {
+    if (bytes > 0) {
+        *list_add(LLVMTypeRef, elements) = LLVMArrayType(LLVMInt8Type(), bytes);
+    }
+}
+
+typedef struct FieldPlan {
+    AstNodeStructField* node;
+    Type* type;
+    uint64_t size;
+    unsigned int align;
+    int declared_index;
+} FieldPlan;
+
+// Offset of each field in the given order; returns the end of the last one.
+static uint64_t place_fields(FieldPlan** order, int count, uint64_t* offsets) {
+    uint64_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        offsets[i] = align_up(offset, order[i]->align);
+        offset = offsets[i] + order[i]->size;
+    }
+
+    return offset;
+}
+
+// Hot fields first, then the most aligned, so smaller fields fill the gaps
+// after larger ones. A cacheline field keeps its place and starts a new group,
+// since it marks where one line's data ends.
+static int compare_fields(const void* a, const void* b) {
+    const FieldPlan* left = *(FieldPlan* const*)a;
+    const FieldPlan* right = *(FieldPlan* const*)b;
+
+    int left_hot = (left->node->attributes & LayoutAttribute_Hot) != 0;
+    int right_hot = (right->node->attributes & LayoutAttribute_Hot) != 0;
+    if (left_hot != right_hot) {
+        return right_hot - left_hot;
+    }
+    if (left->align != right->align) {
+        return left->align < right->align ? 1 : -1;
+    }
+    return left->declared_index - right->declared_index;
+}
+
+static void reorder_fields(FieldPlan** order, int count) {
+    int group_start = 0;
+    for (int i = 1; i <= count; i++) {
+        if (i == count || (order[i]->node->attributes & LayoutAttribute_Cacheline)) {
+            int first = group_start;
+            // the cacheline field heading a group stays at its head
+            if (order[first]->node->attributes & LayoutAttribute_Cacheline) {
+                first += 1;
+            }
+            if (i > first) {
+                qsort(order + first, i - first, sizeof(FieldPlan*), compare_fields);
+            }
+            group_start = i;
+        }
+    }
+}
+
+Type* layout_struct(CodegenContext* context, AstNode* declaration) {
+    AstNodeStruct* node = &declaration->data.struct_declaration;
+
+    // registered before the fields, so a field can point back at the struct
+    Type* type = calloc(1, sizeof(Type));
+    type->kind = TypeKind_Struct;
+    type->name = node->name;
+    type->llvm_type = LLVMStructCreateNamed(LLVMGetGlobalContext(), node->name.data);
+    map_insert(&context->types, type->name, type);
+
+    int is_packed = node->attributes & LayoutAttribute_Packed;
+    unsigned int cacheline = layout_cacheline_size(context);
+
+    int count = node->fields.length;
+    FieldPlan* plans = calloc(count, sizeof(FieldPlan));
+    FieldPlan** order = calloc(count, sizeof(FieldPlan*));
+    uint64_t* offsets = calloc(count, sizeof(uint64_t));
+    unsigned int struct_align = 1;
+
+    for (int i = 0; i < count; i++) {
+        AstNodeStructField* field_node = &(*list_get(AstNode*, &node->fields, i))->data.struct_field;
+        Type* field_type = type_from_ast(context, field_node->type);
+
+        if (field_type->kind == TypeKind_Struct && field_type->align == 0) {
+            sil_panic("Code Gen Error: Struct %.*s contains itself", node->name.length, node->name.data);
+        }
+        if (field_type->kind == TypeKind_Void || field_type->kind == TypeKind_Never) {
+            sil_panic(
+                "Code Gen Error: Field %.*s.%.*s cannot be %.*s",
+                node->name.length,
+                node->name.data,
+                field_node->name.length,
+                field_node->name.data,
+                field_type->name.length,
+                field_type->name.data
+            );
+        }
+        for (int j = 0; j < i; j++) {
+            if (string_compare(plans[j].node->name, field_node->name)) {
+                sil_panic("Code Gen Error: Duplicate field %.*s.%.*s", node->name.length, node->name.data, field_node->name.length, field_node->name.data);
+            }
+        }
+
+        // packed drops natural alignment, but not one asked for explicitly
+        unsigned int align = is_packed ? 1 : type_align(context, field_type);
+        if (field_node->align > align) {
+            align = field_node->align;
+        }
+        if ((field_node->attributes & LayoutAttribute_Cacheline) && cacheline > align) {
+            align = cacheline;
+        }
+
+        plans[i] = (FieldPlan){ field_node, field_type, type_size(context, field_type), align, i };
+        order[i] = &plans[i];
+        if (align > struct_align) {
+            struct_align = align;
+        }
+    }
+
+    if (node->align > struct_align) {
+        struct_align = node->align;
+    }
+    if ((node->attributes & LayoutAttribute_Cacheline) && cacheline > struct_align) {
+        struct_align = cacheline;
+    }
+
+    // the size rounds up so every element of an array stays aligned
+    type->declared_size = align_up(place_fields(order, count, offsets), struct_align);
+
+    // only code that sees the struct through C or a wire format cares about
+    // the order, and it says so with extern or packed
+    if (!(node->attributes & (LayoutAttribute_Extern | LayoutAttribute_Packed))) {
+        reorder_fields(order, count);
+    }
+    uint64_t end = place_fields(order, count, offsets);
+
+    type->size = align_up(end, struct_align);
+    type->align = struct_align;
+
+    List elements = {0};
+    uint64_t offset = 0;
+    for (int i = 0; i < count; i++) {
+        add_padding(&elements, offsets[i] - offset);
+
+        StructField* field = list_add(StructField, &type->fields);
+        field->name = order[i]->node->name;
+        field->type = order[i]->type;
+        field->offset = offsets[i];
+        field->align = order[i]->align;
+        field->index = elements.length;
+        *list_add(LLVMTypeRef, &elements) = order[i]->type->llvm_type;
+
+        offset = offsets[i] + order[i]->size;
+    }
+    add_padding(&elements, type->size - offset);
+
+    LLVMStructSetBody(type->llvm_type, elements.data, elements.length, 1);
+    list_delete(&elements);
+    free(plans);
+    free(order);
+    free(offsets);
+
+    list_push(Type*, &context->structs, &type);
+
+    return type;
+}
+
+void layout_report_print(CodegenContext* context) {
+    if (!context->options->layout_report) {
+        return;
+    }
+
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    printf("\nLayout report (%s, %u byte cache lines)\n", triple, layout_cacheline_size(context));
+    LLVMDisposeMessage(triple);
+
+    for (int i = 0; i < context->structs.length; i++) {
+        Type* type = *list_get(Type*, &context->structs, i);
+
+        uint64_t padding = type->size;
+        for (int j = 0; j < type->fields.length; j++) {
+            StructField* field = list_get(StructField, &type->fields, j);
+            padding -= type_size(context, field->type);
+        }
+
+        printf(
+            "\nstruct %.*s: %llu bytes, align %u, %llu bytes padding",
+            type->name.length,
+            type->name.data,
+            (unsigned long long)type->size,
+            type->align,
+            (unsigned long long)padding
+        );
+        if (type->declared_size > type->size) {
+            printf(
+                ", %llu bytes saved by reordering",
+                (unsigned long long)(type->declared_size - type->size)
+            );
+        }
+        printf("\n");
+        printf("%8s %8s %8s  %s\n", "offset", "size", "align", "field");
+
+        uint64_t offset = 0;
+        for (int j = 0; j < type->fields.length; j++) {
+            StructField* field = list_get(StructField, &type->fields, j);
+            if (field->offset > offset) {
+                printf("%8llu %8llu %8s  (padding)\n", (unsigned long long)offset, (unsigned long long)(field->offset - offset), "");
+            }
+
+            uint64_t size = type_size(context, field->type);
+            printf(
+                "%8llu %8llu %8u  %.*s: %.*s\n",
+                (unsigned long long)field->offset,
+                (unsigned long long)size,
+                field->align,
+                field->name.length,
+                field->name.data,
+                field->type->name.length,
+                field->type->name.data
+            );
+            offset = field->offset + size;
+        }
+
+        if (type->size > offset) {
+            printf("%8llu %8llu %8s  (padding)\n", (unsigned long long)offset, (unsigned long long)(type->size - offset), "");
+        }
+    }
+}
@@ -0,0 +1,24 @@
+#ifndef CODEGEN_LAYOUT_H
+#define CODEGEN_LAYOUT_H
+
+#include "codegen/type.h"
+#include "parser/parser.h"
+
+#include <stdint.h>
+
+typedef struct CodegenContext CodegenContext;
+
+// Places the fields of a struct declaration and creates its type. Padding
+// is explicit, so the LLVM struct is packed and sil decides every offset.
+Type* layout_struct(CodegenContext* context, AstNode* declaration);
+
+// Line size of the target's data cache, the alignment of cacheline.
+unsigned int layout_cacheline_size(CodegenContext* context);
+
+// Alignment of the address at offset into memory aligned to align.
+unsigned int layout_offset_align(unsigned int align, uint64_t offset);
+
+// Prints the offset, size and padding of every field of every struct.
+void layout_report_print(CodegenContext* context);
+
+#endif
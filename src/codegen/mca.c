@@ -0,0 +1,296 @@
+#include "mca.h"
+
+#include "codegen.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/TargetMachine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef SIL_LLVM_BINDIR
+#define SIL_LLVM_BINDIR ""
+#endif
+
+
+void mca_append_text(List* output, const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        *list_add(char, output) = text[i];
+    }
+}
+
+static void append_literal(List* output, const char* text) {
+    mca_append_text(output, text, strlen(text));
+}
+
+const char* mca_comment_prefix(CodegenContext* context) {
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    const char* prefix = "#";
+    if (strncmp(triple, "arm", 3) == 0 || strncmp(triple, "thumb", 5) == 0) {
+        prefix = "@";
+    } else if (strncmp(triple, "aarch64", 7) == 0 || strncmp(triple, "arm64", 5) == 0) {
+        prefix = "//";
+    }
+    LLVMDisposeMessage(triple);
+
+    return prefix;
+}
+
+char* mca_emit_assembly(CodegenContext* context) {
+    LLVMModuleRef module = LLVMCloneModule(context->module);
+
+    // verbose comments carry the IR block names loop bounds are keyed on
+    LLVMSetTargetMachineAsmVerbosity(context->target_machine, 1);
+
+    char* error;
+    LLVMMemoryBufferRef buffer;
+    if (LLVMTargetMachineEmitToMemoryBuffer(
+        context->target_machine,
+        module,
+        LLVMAssemblyFile,
+        &error,
+        &buffer
+    )) {
+        sil_panic("MCA Error: %s", error);
+    }
+
+    size_t size = LLVMGetBufferSize(buffer);
+    char* assembly = malloc(size + 1);
+    memcpy(assembly, LLVMGetBufferStart(buffer), size);
+    assembly[size] = 0;
+
+    LLVMDisposeMemoryBuffer(buffer);
+    LLVMDisposeModule(module);
+
+    return assembly;
+}
+
+static int is_label(const char* line, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (line[i] == ':') {
+            return 1;
+        }
+        if (line[i] == ' ' || line[i] == '\t') {
+            return 0;
+        }
+    }
+    return 0;
+}
+
+static int is_function_label(const char* line, size_t length, String fn) {
+    // Mach-O prefixes C symbols with an underscore
+    if (length > 0 && line[0] == '_' && fn.data[0] != '_') {
+        line += 1;
+        length -= 1;
+    }
+    return length > fn.length
+        && strncmp(line, fn.data, fn.length) == 0
+        && line[fn.length] == ':';
+}
+
+int mca_is_mode_directive(const char* line) {
+    const char* directives[] = { ".syntax", ".code", ".thumb", ".arm", ".cpu", ".fpu", ".arch", ".intel_syntax", ".att_syntax" };
+    for (int i = 0; i < sizeof(directives) / sizeof(directives[0]); i++) {
+        size_t length = strlen(directives[i]);
+        if (strncmp(line, directives[i], length) == 0
+            && (line[length] == ' ' || line[length] == '\t' || line[length] == '\n' || line[length] == 0)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int mca_append_function(CodegenContext* context, List* output, char* assembly, String fn) {
+    const char* comment = mca_comment_prefix(context);
+    int in_function = 0;
+
+    char* line = assembly;
+    while (*line != 0) {
+        char* line_end = strchr(line, '\n');
+        if (line_end == NULL) {
+            line_end = line + strlen(line);
+        }
+
+        char* text = line;
+        while (text < line_end && (*text == ' ' || *text == '\t')) {
+            text++;
+        }
+        size_t length = line_end - text;
+
+        if (!in_function) {
+            if (is_function_label(text, length, fn)) {
+                in_function = 1;
+            } else if (mca_is_mode_directive(text)) {
+                mca_append_text(output, text, length);
+                append_literal(output, "\n");
+            }
+        } else if (strncmp(text, ".Lfunc_end", 10) == 0 || strncmp(text, "Lfunc_end", 9) == 0) {
+            return 1;
+        } else if (length == 0 || strncmp(text, comment, strlen(comment)) == 0) {
+        } else if (text[0] == '.') {
+            if (mca_is_mode_directive(text)) {
+                mca_append_text(output, text, length);
+                append_literal(output, "\n");
+            }
+        } else if (!is_label(text, length)) {
+            mca_append_text(output, text, length);
+            append_literal(output, "\n");
+        }
+
+        line = *line_end == 0 ? line_end : line_end + 1;
+    }
+
+    return in_function;
+}
+
+void mca_append_marker(CodegenContext* context, List* output, const char* marker, String name) {
+    // llvm-mca only sees region markers in '#' comments on AArch64
+    const char* comment = mca_comment_prefix(context);
+    append_literal(output, strcmp(comment, "//") == 0 ? "#" : comment);
+    append_literal(output, " ");
+    append_literal(output, marker);
+    append_literal(output, " ");
+    mca_append_text(output, name.data, name.length);
+    append_literal(output, "\n");
+}
+
+FILE* mca_run(CodegenContext* context, List* source, const char* const* arguments) {
+    char path[] = "/tmp/sil-mca-XXXXXX";
+    int descriptor = mkstemp(path);
+    if (descriptor == -1) {
+        sil_panic("MCA Error: Could not create temporary file");
+    }
+
+    FILE* file = fdopen(descriptor, "w");
+    fwrite(source->data, 1, source->length, file);
+    fclose(file);
+
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    char* cpu = LLVMGetTargetMachineCPU(context->target_machine);
+
+    const char* bindir = SIL_LLVM_BINDIR;
+    size_t program_length = strlen(bindir) + strlen("/llvm-mca") + 1;
+    char* program = malloc(program_length);
+    snprintf(program, program_length, "%s%sllvm-mca", bindir, bindir[0] != 0 ? "/" : "");
+
+    size_t triple_length = strlen("-mtriple=") + strlen(triple) + 1;
+    char* triple_argument = malloc(triple_length);
+    snprintf(triple_argument, triple_length, "-mtriple=%s", triple);
+
+    size_t cpu_length = strlen("-mcpu=") + strlen(cpu) + 1;
+    char* cpu_argument = malloc(cpu_length);
+    snprintf(cpu_argument, cpu_length, "-mcpu=%s", cpu);
+
+    // triple and cpu come from the command line, so they go to llvm-mca as
+    // separate arguments instead of through a shell
+    List argv = {0};
+    *list_add(char*, &argv) = program;
+    *list_add(char*, &argv) = triple_argument;
+    *list_add(char*, &argv) = cpu_argument;
+    for (int i = 0; arguments[i] != NULL; i++) {
+        *list_add(char*, &argv) = (char*)arguments[i];
+    }
+    *list_add(char*, &argv) = path;
+    *list_add(char*, &argv) = NULL;
+
+    // stdout and stderr both go to the returned file
+    FILE* output = tmpfile();
+    fflush(stdout);
+    fflush(stderr);
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        sil_panic("MCA Error: Could not run %s", program);
+    }
+    if (pid == 0) {
+        dup2(fileno(output), STDOUT_FILENO);
+        dup2(fileno(output), STDERR_FILENO);
+        if (bindir[0] != 0) {
+            execv(program, (char**)argv.data);
+        } else {
+            execvp(program, (char**)argv.data);
+        }
+        fprintf(stderr, "Could not run %s\n", program);
+        _exit(127);
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        rewind(output);
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), output)) > 0) {
+            fwrite(buffer, 1, read, stderr);
+        }
+        sil_panic("MCA Error: llvm-mca failed");
+    }
+
+    unlink(path);
+    list_delete(&argv);
+    free(program);
+    free(triple_argument);
+    free(cpu_argument);
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+
+    rewind(output);
+    return output;
+}
+
+void mca_report_print(CodegenContext* context) {
+    char* functions = context->options->mca_functions;
+    if (functions == NULL) {
+        return;
+    }
+
+    char* assembly = mca_emit_assembly(context);
+    List source = {0};
+    int region_count = 0;
+
+    printf("\nMCA report\n\n");
+
+    char* name = functions;
+    while (*name != 0) {
+        char* name_end = strchr(name, ',');
+        if (name_end == NULL) {
+            name_end = name + strlen(name);
+        }
+        String fn = { name, name_end - name };
+
+        List body = {0};
+        if (mca_append_function(context, &body, assembly, fn)) {
+            mca_append_marker(context, &source, "LLVM-MCA-BEGIN", fn);
+            mca_append_text(&source, body.data, body.length);
+            mca_append_marker(context, &source, "LLVM-MCA-END", fn);
+            region_count += 1;
+        } else if (map_get(&context->function_map, fn) == NULL) {
+            printf("%.*s: no such function\n", fn.length, fn.data);
+        } else {
+            printf("%.*s: not emitted, inlined into every caller\n", fn.length, fn.data);
+        }
+        list_delete(&body);
+
+        name = *name_end == 0 ? name_end : name_end + 1;
+    }
+
+    // in-order cpus have no bottleneck analysis, the timeline shows the chain
+    if (region_count > 0) {
+        const char* arguments[] = { "-bottleneck-analysis", "-timeline", "-timeline-max-iterations=1", NULL };
+        FILE* output = mca_run(context, &source, arguments);
+
+        fflush(stdout);
+        char buffer[4096];
+        size_t read;
+        while ((read = fread(buffer, 1, sizeof(buffer), output)) > 0) {
+            fwrite(buffer, 1, read, stdout);
+        }
+        fclose(output);
+    }
+
+    list_delete(&source);
+    free(assembly);
+}
@@ -0,0 +1,38 @@
+#ifndef CODEGEN_MCA_H
+#define CODEGEN_MCA_H
+
+#include "list.h"
+#include "string_buffer.h"
+
+#include <stdio.h>
+
+typedef struct CodegenContext CodegenContext;
+
+void mca_append_text(List* output, const char* text, size_t length);
+
+// Comment syntax of the target's assembly, needed for region markers.
+const char* mca_comment_prefix(CodegenContext* context);
+
+// Directives that change how the following instructions are parsed
+// (.syntax, .code, .cpu...) and have to be kept in front of any region.
+int mca_is_mode_directive(const char* line);
+
+// Assembly for the optimized module, emitted from a clone so the module
+// handed to the object emitter stays untouched.
+char* mca_emit_assembly(CodegenContext* context);
+
+// Appends the instructions of fn, one per line, without labels and
+// directives llvm-mca does not need. Returns 0 when fn was not emitted.
+int mca_append_function(CodegenContext* context, List* output, char* assembly, String fn);
+
+// Appends a region marker in the target's comment syntax.
+void mca_append_marker(CodegenContext* context, List* output, const char* marker, String name);
+
+// Runs llvm-mca for the target cpu on the given source and returns its
+// output. arguments is a NULL terminated list of extra llvm-mca options.
+FILE* mca_run(CodegenContext* context, List* source, const char* const* arguments);
+
+// Prints llvm-mca's analysis of every function named in --mca-report.
+void mca_report_print(CodegenContext* context);
+
+#endif
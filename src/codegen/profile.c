@@ -0,0 +1,58 @@
+#include "profile.h"
+
+#include "codegen.h"
+#include "list.h"
+
+#include "llvm-c/Core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+void profile_add_llvm_options(CodegenContext* context, List* arguments) {
+    CodegenOptions* options = context->options;
+    if (options->profile_use_path == NULL) {
+        return;
+    }
+
+    // pgo-instr-use from a pipeline string has no filename parameter and
+    // falls back to this flag.
+    const char* flag = "-pgo-test-profile-file=";
+    char* argument = malloc(strlen(flag) + strlen(options->profile_use_path) + 1);
+    strcpy(argument, flag);
+    strcat(argument, options->profile_use_path);
+    list_push(char*, arguments, &argument);
+}
+
+void profile_emit_globals(CodegenContext* context) {
+    CodegenOptions* options = context->options;
+    if (!options->profile_generate || options->profile_generate_path == NULL) {
+        return;
+    }
+
+    // Same variable clang emits for -fprofile-generate=<path>. Weak so that
+    // several instrumented objects can be linked together.
+    char* path = options->profile_generate_path;
+    LLVMValueRef path_constant = LLVMConstString(path, strlen(path), 0);
+    LLVMValueRef filename = LLVMAddGlobal(
+        context->module,
+        LLVMTypeOf(path_constant),
+        "__llvm_profile_filename"
+    );
+    LLVMSetInitializer(filename, path_constant);
+    LLVMSetGlobalConstant(filename, 1);
+    LLVMSetLinkage(filename, LLVMWeakAnyLinkage);
+}
+
+const char* profile_pipeline(CodegenContext* context) {
+    CodegenOptions* options = context->options;
+    if (options->profile_generate) {
+        return "pgo-instr-gen,instrprof";
+    }
+
+    if (options->profile_use_path != NULL) {
+        return "pgo-instr-use";
+    }
+
+    return NULL;
+}
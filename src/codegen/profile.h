@@ -0,0 +1,17 @@
+#ifndef CODEGEN_PROFILE_H
+#define CODEGEN_PROFILE_H
+
+#include "list.h"
+
+typedef struct CodegenContext CodegenContext;
+
+// Adds the llvm command line flags needed by the profile passes.
+void profile_add_llvm_options(CodegenContext* context, List* arguments);
+
+// Emits module level data the profile runtime reads at exit.
+void profile_emit_globals(CodegenContext* context);
+
+// Passes that have to run on the unoptimized module, before the -O pipeline.
+const char* profile_pipeline(CodegenContext* context);
+
+#endif
@@ -0,0 +1,62 @@
+#include "scope.h"
+
+#include "list.h"
+#include "util.h"
+
+#include <stdlib.h>
+
+
+void scope_init(SymbolTable* table, size_t symbol_count) {
+    table->bindings = (List){0};
+    table->scope_starts = (List){0};
+    table->symbol_count = symbol_count;
+    table->innermost = malloc(sizeof(int) * (symbol_count > 0 ? symbol_count : 1));
+    for (size_t i = 0; i < symbol_count; i++) {
+        table->innermost[i] = -1;
+    }
+}
+
+void scope_push(SymbolTable* table) {
+    size_t start = table->bindings.length;
+    list_push(size_t, &table->scope_starts, &start);
+}
+
+void scope_pop(SymbolTable* table) {
+    if (table->scope_starts.length == 0) {
+        sil_panic("Code Gen Error: Scope underflow");
+    }
+
+    table->scope_starts.length -= 1;
+    size_t start = *list_get(size_t, &table->scope_starts, table->scope_starts.length);
+
+    // unhide whatever each binding of the scope shadowed
+    for (size_t i = table->bindings.length; i > start; i--) {
+        Binding* binding = list_get(Binding, &table->bindings, i - 1);
+        table->innermost[binding->symbol] = binding->shadowed;
+    }
+    table->bindings.length = start;
+}
+
+Local* scope_bind(SymbolTable* table, unsigned int symbol, String name) {
+    if (symbol >= table->symbol_count) {
+        sil_panic("Code Gen Error: Symbol %.*s was not interned", name.length, name.data);
+    }
+
+    int index = table->bindings.length;
+    Binding* binding = list_add(Binding, &table->bindings);
+    binding->local = (Local){ .name = name };
+    binding->symbol = symbol;
+    binding->shadowed = table->innermost[symbol];
+    table->innermost[symbol] = index;
+
+    return &binding->local;
+}
+
+Local* scope_find(SymbolTable* table, unsigned int symbol) {
+    if (symbol >= table->symbol_count || table->innermost[symbol] == -1) {
+        return NULL;
+    }
+
+    Binding* binding = list_get(Binding, &table->bindings, table->innermost[symbol]);
+    return &binding->local;
+}
@@ -0,0 +1,44 @@
+#ifndef CODEGEN_SCOPE_H
+#define CODEGEN_SCOPE_H
+
+#include "codegen/type.h"
+#include "list.h"
+#include "string_buffer.h"
+
+#include <stddef.h>
+
+// A named value in scope. Locals in memory, the mutable ones and arrays,
+// hold their entry-block stack slot.
+typedef struct Local {
+    String name;
+    Value value;
+    int is_mutable;
+    int in_memory;
+} Local;
+
+typedef struct Binding {
+    Local local;
+    unsigned int symbol;
+    // binding of the same symbol this one hides, or -1
+    int shadowed;
+} Binding;
+
+// Every binding of a function lives in one array. A scope is just the array
+// length when it was entered, and innermost maps each interned symbol id to
+// its visible binding, so lookups never search and scopes never allocate.
+typedef struct SymbolTable {
+    List bindings;
+    List scope_starts;
+    int* innermost;
+    size_t symbol_count;
+} SymbolTable;
+
+void scope_init(SymbolTable* table, size_t symbol_count);
+void scope_push(SymbolTable* table);
+void scope_pop(SymbolTable* table);
+
+Local* scope_bind(SymbolTable* table, unsigned int symbol, String name);
+// NULL when the symbol has no binding in scope.
+Local* scope_find(SymbolTable* table, unsigned int symbol);
+
+#endif
@@ -0,0 +1,287 @@
+#include "size_report.h"
+
+#include "codegen.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Object.h"
+#include "llvm-c/Target.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef struct DataSize {
+    String value;
+    uint64_t bytes;
+} DataSize;
+
+static int count_instructions(LLVMValueRef function) {
+    int count = 0;
+    LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function);
+    for (; block != NULL; block = LLVMGetNextBasicBlock(block)) {
+        LLVMValueRef instruction = LLVMGetFirstInstruction(block);
+        for (; instruction != NULL; instruction = LLVMGetNextInstruction(instruction)) {
+            count += 1;
+        }
+    }
+
+    return count;
+}
+
+void size_report_before(CodegenContext* context) {
+    if (!context->options->size_report) {
+        return;
+    }
+
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used) {
+            continue;
+        }
+
+        AstNode* node = entry->value;
+        if (node->type != AstNodeType_Fn) {
+            continue;
+        }
+
+        FunctionSize* size = list_add(FunctionSize, &context->function_sizes);
+        size->name = node->data.fn.prototype->data.fn_proto.name;
+        size->ir_before = count_instructions(LLVMGetNamedFunction(context->module, size->name.data));
+        size->ir_after = 0;
+        size->code_bytes = 0;
+    }
+}
+
+void size_report_after(CodegenContext* context) {
+    if (!context->options->size_report) {
+        return;
+    }
+
+    // functions that were inlined everywhere and dropped stay at 0
+    for (int i = 0; i < context->function_sizes.length; i++) {
+        FunctionSize* size = list_get(FunctionSize, &context->function_sizes, i);
+        LLVMValueRef function = LLVMGetNamedFunction(context->module, size->name.data);
+        if (function != NULL) {
+            size->ir_after = count_instructions(function);
+        }
+    }
+}
+
+static void read_code_bytes(CodegenContext* context) {
+    char* error = NULL;
+    LLVMBinaryRef binary = LLVMCreateBinary(context->object, LLVMGetGlobalContext(), &error);
+    if (binary == NULL) {
+        sil_panic("Size Report Error: %s", error);
+    }
+
+    LLVMSymbolIteratorRef symbol = LLVMObjectFileCopySymbolIterator(binary);
+    for (; !LLVMObjectFileIsSymbolIteratorAtEnd(binary, symbol); LLVMMoveToNextSymbol(symbol)) {
+        const char* symbol_name = LLVMGetSymbolName(symbol);
+
+        // Mach-O prefixes C symbols with an underscore
+        for (int i = 0; i < context->function_sizes.length; i++) {
+            FunctionSize* size = list_get(FunctionSize, &context->function_sizes, i);
+            if ((string_compare_literal(size->name, symbol_name) && symbol_name[size->name.length] == 0)
+                || (symbol_name[0] == '_'
+                    && string_compare_literal(size->name, symbol_name + 1)
+                    && symbol_name[size->name.length + 1] == 0)) {
+                size->code_bytes = LLVMGetSymbolSize(symbol);
+            }
+        }
+    }
+
+    LLVMDisposeSymbolIterator(symbol);
+    LLVMDisposeBinary(binary);
+}
+
+static List collect_strings(CodegenContext* context) {
+    List strings = {0};
+    LLVMTargetDataRef data_layout = LLVMGetModuleDataLayout(context->module);
+
+    LLVMValueRef global = LLVMGetFirstGlobal(context->module);
+    for (; global != NULL; global = LLVMGetNextGlobal(global)) {
+        LLVMValueRef initializer = LLVMGetInitializer(global);
+        if (initializer == NULL || !LLVMIsGlobalConstant(global)
+            || LLVMIsAConstantDataSequential(initializer) == NULL
+            || !LLVMIsConstantString(initializer)) {
+            continue;
+        }
+
+        size_t length;
+        const char* value = LLVMGetAsString(initializer, &length);
+
+        DataSize* size = list_add(DataSize, &strings);
+        size->value = (String){ (char*)value, length };
+        size->bytes = LLVMABISizeOfType(data_layout, LLVMGlobalGetValueType(global));
+    }
+
+    return strings;
+}
+
+static int compare_function_sizes(const void* a, const void* b) {
+    const FunctionSize* left = a;
+    const FunctionSize* right = b;
+    if (left->code_bytes != right->code_bytes) {
+        return left->code_bytes < right->code_bytes ? 1 : -1;
+    }
+    if (left->ir_after != right->ir_after) {
+        return left->ir_after < right->ir_after ? 1 : -1;
+    }
+    return strcmp(left->name.data, right->name.data);
+}
+
+static int compare_data_sizes(const void* a, const void* b) {
+    const DataSize* left = a;
+    const DataSize* right = b;
+    if (left->bytes == right->bytes) {
+        return 0;
+    }
+    return left->bytes < right->bytes ? 1 : -1;
+}
+
+// C escapes for the text report.
+static void print_c_escaped(FILE* file, String value) {
+    for (int i = 0; i < value.length; i++) {
+        unsigned char c = value.data[i];
+        switch (c) {
+            case '\n': fputs("\\n", file); break;
+            case '\t': fputs("\\t", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\0': fputs("\\0", file); break;
+            case '"': fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            default:
+                if (c < 0x20 || c >= 0x7f) {
+                    fprintf(file, "\\x%02x", c);
+                } else {
+                    fputc(c, file);
+                }
+                break;
+        }
+    }
+}
+
+// JSON string escapes.
+static void print_json_escaped(FILE* file, String value) {
+    for (int i = 0; i < value.length; i++) {
+        unsigned char c = value.data[i];
+        if (c == '"' || c == '\\') {
+            fprintf(file, "\\%c", c);
+        } else if (c < 0x20 || c >= 0x7f) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+}
+
+static void print_text(List* functions, List* strings, const char* triple) {
+    int total_before = 0;
+    int total_after = 0;
+    uint64_t total_code = 0;
+    uint64_t total_strings = 0;
+
+    printf("\nSize report (%s)\n\n", triple);
+    printf("%-32s %10s %10s %12s\n", "function", "IR before", "IR after", "code bytes");
+    for (int i = 0; i < functions->length; i++) {
+        FunctionSize* size = list_get(FunctionSize, functions, i);
+        printf(
+            "%-32.*s %10d %10d %12llu\n",
+            size->name.length,
+            size->name.data,
+            size->ir_before,
+            size->ir_after,
+            (unsigned long long)size->code_bytes
+        );
+        total_before += size->ir_before;
+        total_after += size->ir_after;
+        total_code += size->code_bytes;
+    }
+    printf("%-32s %10d %10d %12llu\n\n", "total", total_before, total_after, (unsigned long long)total_code);
+
+    printf("%12s  %s\n", "bytes", "string data");
+    for (int i = 0; i < strings->length; i++) {
+        DataSize* size = list_get(DataSize, strings, i);
+        int length = size->value.length > 24 ? 24 : size->value.length;
+        printf("%12llu  \"", (unsigned long long)size->bytes);
+        print_c_escaped(stdout, (String){ size->value.data, length });
+        printf("\"%s\n", length < size->value.length ? "..." : "");
+        total_strings += size->bytes;
+    }
+    printf("%12llu  total\n", (unsigned long long)total_strings);
+}
+
+static void print_json(FILE* file, List* functions, List* strings, const char* triple) {
+    int total_before = 0;
+    int total_after = 0;
+    uint64_t total_code = 0;
+    uint64_t total_strings = 0;
+
+    fprintf(file, "{\n  \"target\": \"%s\",\n  \"functions\": [", triple);
+    for (int i = 0; i < functions->length; i++) {
+        FunctionSize* size = list_get(FunctionSize, functions, i);
+        fprintf(file, "%s\n    {\"name\": \"", i == 0 ? "" : ",");
+        print_json_escaped(file, size->name);
+        fprintf(
+            file,
+            "\", \"ir_before\": %d, \"ir_after\": %d, \"code_bytes\": %llu}",
+            size->ir_before,
+            size->ir_after,
+            (unsigned long long)size->code_bytes
+        );
+        total_before += size->ir_before;
+        total_after += size->ir_after;
+        total_code += size->code_bytes;
+    }
+
+    fprintf(file, "\n  ],\n  \"strings\": [");
+    for (int i = 0; i < strings->length; i++) {
+        DataSize* size = list_get(DataSize, strings, i);
+        fprintf(file, "%s\n    {\"value\": \"", i == 0 ? "" : ",");
+        print_json_escaped(file, size->value);
+        fprintf(file, "\", \"bytes\": %llu}", (unsigned long long)size->bytes);
+        total_strings += size->bytes;
+    }
+
+    fprintf(
+        file,
+        "\n  ],\n  \"totals\": {\"ir_before\": %d, \"ir_after\": %d, \"code_bytes\": %llu, \"string_bytes\": %llu}\n}\n",
+        total_before,
+        total_after,
+        (unsigned long long)total_code,
+        (unsigned long long)total_strings
+    );
+}
+
+void size_report_print(CodegenContext* context) {
+    if (!context->options->size_report) {
+        return;
+    }
+
+    read_code_bytes(context);
+
+    List* functions = &context->function_sizes;
+    qsort(functions->data, functions->length, sizeof(FunctionSize), compare_function_sizes);
+
+    List strings = collect_strings(context);
+    qsort(strings.data, strings.length, sizeof(DataSize), compare_data_sizes);
+
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+
+    print_text(functions, &strings, triple);
+
+    char* path = context->options->size_report_path;
+    if (path != NULL) {
+        FILE* file = fopen(path, "w");
+        if (file == NULL) {
+            sil_panic("Size Report Error: Could not open %s", path);
+        }
+        print_json(file, functions, &strings, triple);
+        fclose(file);
+    }
+
+    LLVMDisposeMessage(triple);
+    list_delete(&strings);
+}
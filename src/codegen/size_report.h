@@ -0,0 +1,26 @@
+#ifndef CODEGEN_SIZE_REPORT_H
+#define CODEGEN_SIZE_REPORT_H
+
+#include "string_buffer.h"
+
+#include <stdint.h>
+
+typedef struct CodegenContext CodegenContext;
+
+typedef struct FunctionSize {
+    String name;
+    int ir_before;
+    int ir_after;
+    uint64_t code_bytes;
+} FunctionSize;
+
+// Counts the IR instructions of every sil function as codegen produced them.
+void size_report_before(CodegenContext* context);
+
+// Counts them again after the -O pipeline.
+void size_report_after(CodegenContext* context);
+
+// Prints the report, adding machine code bytes from the emitted object.
+void size_report_print(CodegenContext* context);
+
+#endif
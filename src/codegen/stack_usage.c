@@ -0,0 +1,329 @@
+#include "stack_usage.h"
+
+#include "codegen.h"
+#include "hashmap.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Target.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef enum StackBoundType {
+    StackBoundType_Bounded,
+    StackBoundType_Recursive,
+    StackBoundType_External,
+} StackBoundType;
+
+typedef struct StackBound {
+    StackBoundType type;
+    uint64_t frame;
+    uint64_t bytes;
+    int visiting;
+    String deepest_callee;
+    String culprit;
+} StackBound;
+
+typedef struct StackAnalysis {
+    CodegenContext* context;
+    HashMap bounds;
+    uint64_t call_overhead;
+} StackAnalysis;
+
+void stack_usage_add_call(CodegenContext* context, String callee) {
+    if (!context->options->stack_usage) {
+        return;
+    }
+
+    CallEdge* edge = list_add(CallEdge, &context->call_edges);
+    edge->caller = context->current_fn_proto->data.fn_proto.name;
+    edge->callee = callee;
+    edge->is_tail = 0;
+}
+
+void stack_usage_mark_tail_call(CodegenContext* context) {
+    if (!context->options->stack_usage) {
+        return;
+    }
+
+    CallEdge* edge = list_get(CallEdge, &context->call_edges, context->call_edges.length - 1);
+    edge->is_tail = 1;
+}
+
+// PrologEpilogInserter reports every frame larger than warn-stack-size as a
+// diagnostic, which is the only per-function frame size the C api exposes.
+static void stack_size_handler(LLVMDiagnosticInfoRef info, void* user) {
+    CodegenContext* context = user;
+    char* description = LLVMGetDiagInfoDescription(info);
+
+    // "stack frame size (N) exceeds limit (M) in function 'name'"
+    unsigned long long size;
+    char* name = strstr(description, " in function '");
+    char* name_end = name != NULL ? strrchr(description, '\'') : NULL;
+    if (sscanf(description, "stack frame size (%llu)", &size) == 1 && name != NULL && name_end > name) {
+        name += strlen(" in function '");
+
+        StackFrame* frame = list_add(StackFrame, &context->stack_frames);
+        frame->name = string_from_buffer(name, name_end - name);
+        frame->size = size;
+    } else {
+        fprintf(stderr, "%s\n", description);
+    }
+
+    LLVMDisposeMessage(description);
+}
+
+void stack_usage_prepare(CodegenContext* context) {
+    if (!context->options->stack_usage) {
+        return;
+    }
+
+    LLVMValueRef function = LLVMGetFirstFunction(context->module);
+    for (; function != NULL; function = LLVMGetNextFunction(function)) {
+        if (LLVMIsDeclaration(function)) {
+            continue;
+        }
+
+        LLVMAttributeRef attribute = LLVMCreateStringAttribute(
+            LLVMGetGlobalContext(),
+            "warn-stack-size", strlen("warn-stack-size"),
+            "0", 1
+        );
+        LLVMAddAttributeAtIndex(function, LLVMAttributeFunctionIndex, attribute);
+    }
+
+    LLVMContextSetDiagnosticHandler(LLVMGetGlobalContext(), stack_size_handler, context);
+}
+
+static int is_sil_fn(CodegenContext* context, String name) {
+    AstNode* fn = map_get(&context->function_map, name);
+    return fn != NULL && fn->type == AstNodeType_Fn;
+}
+
+static void add_emitted_call(CodegenContext* context, String caller, String callee) {
+    List* edges = &context->call_edges;
+    for (int i = 0; i < edges->length; i++) {
+        CallEdge* edge = list_get(CallEdge, edges, i);
+        if (string_compare(edge->caller, caller) && string_compare(edge->callee, callee)) {
+            return;
+        }
+    }
+
+    CallEdge* edge = list_add(CallEdge, edges);
+    edge->caller = caller;
+    edge->callee = callee;
+    edge->is_tail = 0;
+}
+
+// The optimizer and instrumentation add calls the ast never saw: memcpy and
+// memset libcalls, __sil_enter/__sil_exit and the profile runtime. Every call
+// in the emitted code that does not target a sil fn is treated as unbounded.
+static void collect_emitted_calls(CodegenContext* context) {
+    LLVMValueRef function = LLVMGetFirstFunction(context->module);
+    for (; function != NULL; function = LLVMGetNextFunction(function)) {
+        size_t length;
+        const char* name = LLVMGetValueName2(function, &length);
+        String caller = string_from_buffer((char*)name, length);
+        if (LLVMIsDeclaration(function) || !is_sil_fn(context, caller)) {
+            continue;
+        }
+
+        LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function);
+        for (; block != NULL; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef instruction = LLVMGetFirstInstruction(block);
+            for (; instruction != NULL; instruction = LLVMGetNextInstruction(instruction)) {
+                if (LLVMIsACallInst(instruction) == NULL && LLVMIsAInvokeInst(instruction) == NULL) {
+                    continue;
+                }
+
+                LLVMValueRef called = LLVMGetCalledValue(instruction);
+                if (LLVMIsAFunction(called) == NULL) {
+                    add_emitted_call(context, caller, string_from_buffer("indirect call", strlen("indirect call")));
+                    continue;
+                }
+
+                const char* callee_name = LLVMGetValueName2(called, &length);
+                String callee = string_from_buffer((char*)callee_name, length);
+
+                // intrinsics are expanded inline, except memory intrinsics
+                // that may still be lowered to a libcall
+                if (LLVMGetIntrinsicID(called) != 0) {
+                    const char* libcalls[] = { "memcpy", "memmove", "memset" };
+                    for (size_t i = 0; i < sizeof(libcalls) / sizeof(libcalls[0]); i++) {
+                        size_t prefix = strlen("llvm.") + strlen(libcalls[i]);
+                        if (strncmp(callee_name, "llvm.", 5) == 0
+                            && strncmp(callee_name + 5, libcalls[i], strlen(libcalls[i])) == 0
+                            && strncmp(callee_name + prefix, ".inline", 7) != 0) {
+                            add_emitted_call(context, caller, string_from_buffer((char*)libcalls[i], strlen(libcalls[i])));
+                        }
+                    }
+                    continue;
+                }
+
+                if (!is_sil_fn(context, callee)) {
+                    add_emitted_call(context, caller, callee);
+                }
+            }
+        }
+    }
+}
+
+static uint64_t frame_size(StackAnalysis* analysis, String name) {
+    List* frames = &analysis->context->stack_frames;
+    for (int i = 0; i < frames->length; i++) {
+        StackFrame* frame = list_get(StackFrame, frames, i);
+        if (string_compare(frame->name, name)) {
+            return frame->size;
+        }
+    }
+
+    // frameless leaf, or inlined everywhere and removed
+    return 0;
+}
+
+static StackBound* analyze(StackAnalysis* analysis, String name) {
+    StackBound* bound = map_get(&analysis->bounds, name);
+    if (bound != NULL) {
+        return bound;
+    }
+
+    bound = calloc(1, sizeof(StackBound));
+    map_insert(&analysis->bounds, name, bound);
+
+    if (!is_sil_fn(analysis->context, name)) {
+        bound->type = StackBoundType_External;
+        bound->culprit = name;
+        return bound;
+    }
+
+    bound->visiting = 1;
+    bound->frame = frame_size(analysis, name);
+
+    uint64_t deepest = 0;
+    List* edges = &analysis->context->call_edges;
+    for (int i = 0; i < edges->length; i++) {
+        CallEdge* edge = list_get(CallEdge, edges, i);
+        if (!string_compare(edge->caller, name)) {
+            continue;
+        }
+
+        StackBound* callee = analyze(analysis, edge->callee);
+
+        // a cycle of tail calls keeps reusing one frame
+        if (callee->visiting && edge->is_tail) {
+            continue;
+        }
+        if (callee->visiting) {
+            bound->type = StackBoundType_Recursive;
+            bound->culprit = edge->callee;
+            continue;
+        }
+
+        if (callee->type != StackBoundType_Bounded && bound->type == StackBoundType_Bounded) {
+            bound->type = callee->type;
+            bound->culprit = callee->culprit;
+        }
+
+        // the tail callee's frame replaces this one, so it only counts when
+        // it is deeper than everything else here
+        uint64_t depth = analysis->call_overhead + callee->bytes;
+        if (edge->is_tail && bound->frame >= depth) {
+            continue;
+        }
+        if (edge->is_tail) {
+            depth -= bound->frame;
+        }
+        if (depth > deepest || bound->deepest_callee.data == NULL) {
+            deepest = depth;
+            bound->deepest_callee = edge->callee;
+        }
+    }
+
+    bound->bytes = bound->frame + deepest;
+    bound->visiting = 0;
+
+    return bound;
+}
+
+static void print_entry(StackAnalysis* analysis, String name, const char* kind) {
+    StackBound* bound = analyze(analysis, name);
+
+    printf("%-10s %-24.*s ", kind, name.length, name.data);
+    switch (bound->type) {
+        case StackBoundType_Bounded:
+            printf("%8llu bytes  ", (unsigned long long)bound->bytes);
+            break;
+        case StackBoundType_Recursive:
+            printf("unbounded (recursion through %.*s)  ", bound->culprit.length, bound->culprit.data);
+            break;
+        case StackBoundType_External:
+            printf(
+                ">= %llu bytes, unbounded (calls %.*s outside sil)  ",
+                (unsigned long long)bound->bytes,
+                bound->culprit.length,
+                bound->culprit.data
+            );
+            break;
+    }
+
+    // deepest known path
+    String current = name;
+    printf("%.*s", current.length, current.data);
+    for (int depth = 0; depth < 64; depth++) {
+        StackBound* current_bound = map_get(&analysis->bounds, current);
+        if (current_bound == NULL || current_bound->deepest_callee.data == NULL) {
+            break;
+        }
+        current = current_bound->deepest_callee;
+        printf(" -> %.*s", current.length, current.data);
+    }
+    printf("\n");
+}
+
+void stack_usage_print(CodegenContext* context) {
+    if (!context->options->stack_usage) {
+        return;
+    }
+
+    collect_emitted_calls(context);
+
+    StackAnalysis analysis = {0};
+    analysis.context = context;
+
+    // a call pushes the return address on x86, other targets keep it in a register
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    if (strncmp(triple, "x86_64", 6) == 0 || (triple[0] == 'i' && strncmp(triple + 2, "86", 2) == 0)) {
+        analysis.call_overhead = LLVMPointerSize(LLVMGetModuleDataLayout(context->module));
+    }
+
+    printf("\nStack usage (%s)\n\n", triple);
+    printf("%-32s %12s\n", "function", "frame bytes");
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used || ((AstNode*)entry->value)->type != AstNodeType_Fn) {
+            continue;
+        }
+
+        printf("%-32.*s %12llu\n", entry->key.length, entry->key.data, (unsigned long long)frame_size(&analysis, entry->key));
+    }
+
+    printf("\nWorst case from entry points:\n");
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used || ((AstNode*)entry->value)->type != AstNodeType_Fn) {
+            continue;
+        }
+
+        AstNode* fn_proto = ((AstNode*)entry->value)->data.fn.prototype;
+        if (fn_proto->data.fn_proto.attributes & FnAttribute_Interrupt) {
+            print_entry(&analysis, entry->key, "interrupt");
+        } else if (string_compare_literal(entry->key, "main") && entry->key.length == 4) {
+            print_entry(&analysis, entry->key, "main");
+        }
+    }
+
+    LLVMDisposeMessage(triple);
+}
@@ -0,0 +1,35 @@
+#ifndef CODEGEN_STACK_USAGE_H
+#define CODEGEN_STACK_USAGE_H
+
+#include "string_buffer.h"
+
+#include <stdint.h>
+
+typedef struct CodegenContext CodegenContext;
+
+typedef struct CallEdge {
+    String caller;
+    String callee;
+    // a tail call replaces the caller's frame instead of nesting in it
+    int is_tail;
+} CallEdge;
+
+typedef struct StackFrame {
+    String name;
+    uint64_t size;
+} StackFrame;
+
+// Records a direct call from the function being generated.
+void stack_usage_add_call(CodegenContext* context, String callee);
+
+// Marks the call recorded last as a tail call.
+void stack_usage_mark_tail_call(CodegenContext* context);
+
+// Makes the backend report the frame size of every function it lowers.
+// Has to run after optimization and before the object is emitted.
+void stack_usage_prepare(CodegenContext* context);
+
+// Prints frame sizes and the worst case depth from main and every interrupt.
+void stack_usage_print(CodegenContext* context);
+
+#endif
@@ -0,0 +1,311 @@
+#include "type.h"
+
+#include "codegen.h"
+#include "codegen/layout.h"
+#include "hashmap.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/Target.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+
+static Type* type_intern(CodegenContext* context, Type* prototype, char* name) {
+    String key = string_from_literal(name);
+
+    Type* type = map_get(&context->types, key);
+    if (type != NULL) {
+        return type;
+    }
+
+    type = malloc(sizeof(Type));
+    *type = *prototype;
+    type->name = string_from_buffer(key.data, key.length);
+    map_insert(&context->types, type->name, type);
+
+    return type;
+}
+
+Type* type_void(CodegenContext* context) {
+    Type type = { .kind = TypeKind_Void, .llvm_type = LLVMVoidType() };
+    return type_intern(context, &type, "void");
+}
+
+Type* type_never(CodegenContext* context) {
+    Type type = { .kind = TypeKind_Never, .llvm_type = LLVMVoidType() };
+    return type_intern(context, &type, "!");
+}
+
+Type* type_bool(CodegenContext* context) {
+    Type type = { .kind = TypeKind_Bool, .bits = 1, .llvm_type = LLVMInt1Type() };
+    return type_intern(context, &type, "bool");
+}
+
+Type* type_int(CodegenContext* context, unsigned int bits, int is_signed) {
+    char name[16];
+    snprintf(name, sizeof(name), "%c%u", is_signed ? 'i' : 'u', bits);
+
+    Type type = { .kind = TypeKind_Int, .bits = bits, .is_signed = is_signed, .llvm_type = LLVMIntType(bits) };
+    return type_intern(context, &type, name);
+}
+
+Type* type_float(CodegenContext* context, unsigned int bits) {
+    char name[16];
+    snprintf(name, sizeof(name), "f%u", bits);
+
+    LLVMTypeRef llvm_type;
+    switch (bits) {
+        case 32: llvm_type = LLVMFloatType(); break;
+        case 64: llvm_type = LLVMDoubleType(); break;
+        default: sil_panic("Code Gen Error: Unsupported float width %u", bits);
+    }
+
+    Type type = { .kind = TypeKind_Float, .bits = bits, .llvm_type = llvm_type };
+    return type_intern(context, &type, name);
+}
+
+Type* type_pointer(CodegenContext* context, Type* child) {
+    char* name = malloc(child->name.length + 2);
+    snprintf(name, child->name.length + 2, "*%.*s", (int)child->name.length, child->name.data);
+
+    // LLVM has no pointer to void
+    LLVMTypeRef pointee = child->kind == TypeKind_Void ? LLVMInt8Type() : child->llvm_type;
+    Type type = { .kind = TypeKind_Pointer, .child = child, .llvm_type = LLVMPointerType(pointee, 0) };
+    Type* pointer = type_intern(context, &type, name);
+    free(name);
+
+    return pointer;
+}
+
+Type* type_vector(CodegenContext* context, Type* child, unsigned int lanes) {
+    if (child->kind != TypeKind_Int && child->kind != TypeKind_Float && child->kind != TypeKind_Bool) {
+        sil_panic("Code Gen Error: Vector lanes cannot be %.*s", child->name.length, child->name.data);
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "@Vector(%u, %.*s)", lanes, (int)child->name.length, child->name.data);
+
+    Type type = {
+        .kind = TypeKind_Vector,
+        .bits = child->bits,
+        .is_signed = child->is_signed,
+        .child = child,
+        .lanes = lanes,
+        .llvm_type = LLVMVectorType(child->llvm_type, lanes),
+    };
+    return type_intern(context, &type, name);
+}
+
+static uint64_t align_up(uint64_t offset, unsigned int align) {
+    return (offset + align - 1) / align * align;
+}
+
+// One array per field, each aligned for its elements.
+static void type_soa_columns(CodegenContext* context, Type* type) {
+    Type* record = type->child;
+    List elements = {0};
+    uint64_t offset = 0;
+    type->align = 1;
+
+    for (int i = 0; i < record->fields.length; i++) {
+        StructField* field = list_get(StructField, &record->fields, i);
+        unsigned int align = type_align(context, field->type);
+        uint64_t column_offset = align_up(offset, align);
+        if (column_offset > offset) {
+            *list_add(LLVMTypeRef, &elements) = LLVMArrayType(LLVMInt8Type(), column_offset - offset);
+        }
+
+        StructField* column = list_add(StructField, &type->fields);
+        column->name = field->name;
+        column->type = field->type;
+        column->offset = column_offset;
+        column->align = align;
+        column->index = elements.length;
+        *list_add(LLVMTypeRef, &elements) = LLVMArrayType(field->type->llvm_type, type->length);
+
+        offset = column_offset + type_size(context, field->type) * type->length;
+        if (align > type->align) {
+            type->align = align;
+        }
+    }
+
+    type->size = align_up(offset, type->align);
+    if (type->size > offset) {
+        *list_add(LLVMTypeRef, &elements) = LLVMArrayType(LLVMInt8Type(), type->size - offset);
+    }
+
+    type->llvm_type = LLVMStructType(elements.data, elements.length, 1);
+    list_delete(&elements);
+}
+
+Type* type_array(CodegenContext* context, Type* child, unsigned int length, int is_soa) {
+    if (child->kind == TypeKind_Void || child->kind == TypeKind_Never) {
+        sil_panic("Code Gen Error: Array elements cannot be %.*s", child->name.length, child->name.data);
+    }
+    if (child->kind == TypeKind_Struct && child->align == 0) {
+        sil_panic("Code Gen Error: Struct %.*s contains itself", child->name.length, child->name.data);
+    }
+    if (is_soa && child->kind != TypeKind_Struct) {
+        sil_panic("Code Gen Error: @soa needs struct elements, not %.*s", child->name.length, child->name.data);
+    }
+
+    char* name = malloc(child->name.length + 32);
+    sprintf(name, "%s[%u]%.*s", is_soa ? "@soa " : "", length, (int)child->name.length, child->name.data);
+
+    Type* array = map_get(&context->types, string_from_literal(name));
+    if (array == NULL) {
+        Type type = { .kind = TypeKind_Array, .child = child, .length = length, .is_soa = is_soa };
+        array = type_intern(context, &type, name);
+
+        if (is_soa) {
+            type_soa_columns(context, array);
+        } else {
+            array->llvm_type = LLVMArrayType(child->llvm_type, length);
+            array->size = type_size(context, child) * length;
+            array->align = type_align(context, child);
+        }
+    }
+    free(name);
+
+    return array;
+}
+
+Type* type_slice(CodegenContext* context, Type* child, int is_const) {
+    if (child->kind == TypeKind_Void || child->kind == TypeKind_Never) {
+        sil_panic("Code Gen Error: Slice elements cannot be %.*s", child->name.length, child->name.data);
+    }
+
+    char* name = malloc(child->name.length + 16);
+    sprintf(name, "[]%s%.*s", is_const ? "const " : "", (int)child->name.length, child->name.data);
+
+    // const and mutable slices share the LLVM type, so one converts to the
+    // other without code
+    LLVMTypeRef elements[] = { type_pointer(context, child)->llvm_type, type_usize(context)->llvm_type };
+    Type type = {
+        .kind = TypeKind_Slice,
+        .child = child,
+        .is_const = is_const,
+        .llvm_type = LLVMStructType(elements, 2, 0),
+    };
+    Type* slice = type_intern(context, &type, name);
+    free(name);
+
+    return slice;
+}
+
+Type* type_usize(CodegenContext* context) {
+    // pointer sized for the target, not the host
+    unsigned int bits = LLVMPointerSize(LLVMGetModuleDataLayout(context->module)) * 8;
+    return type_int(context, bits, 0);
+}
+
+Type* type_from_ast(CodegenContext* context, AstNode* type_name) {
+    if (type_name->data.type_name.type == AstNodeTypeNameType_Pointer) {
+        return type_pointer(context, type_from_ast(context, type_name->data.type_name.child_type));
+    }
+    if (type_name->data.type_name.type == AstNodeTypeNameType_Array) {
+        Type* child = type_from_ast(context, type_name->data.type_name.child_type);
+        return type_array(context, child, type_name->data.type_name.length, type_name->data.type_name.is_soa);
+    }
+    if (type_name->data.type_name.type == AstNodeTypeNameType_Slice) {
+        Type* child = type_from_ast(context, type_name->data.type_name.child_type);
+        return type_slice(context, child, type_name->data.type_name.is_const);
+    }
+    if (type_name->data.type_name.type == AstNodeTypeNameType_Named) {
+        return type_named(context, type_name->data.type_name.name);
+    }
+    if (type_name->data.type_name.type == AstNodeTypeNameType_Vector) {
+        Type* child = type_from_ast(context, type_name->data.type_name.child_type);
+        return type_vector(context, child, type_name->data.type_name.lanes);
+    }
+
+    switch (type_name->data.type_name.primitive) {
+        case AstTypeName_unreachable: return type_never(context);
+        case AstTypeName_void: return type_void(context);
+        case AstTypeName_bool: return type_bool(context);
+        case AstTypeName_int:
+            return type_int(context, type_name->data.type_name.bits, type_name->data.type_name.is_signed);
+        case AstTypeName_f32: return type_float(context, 32);
+        case AstTypeName_f64: return type_float(context, 64);
+        case AstTypeName_isize: {
+            Type* usize = type_usize(context);
+            return type_int(context, usize->bits, 1);
+        }
+        case AstTypeName_usize: return type_usize(context);
+        default: sil_panic("Code Gen Error: Cannot convert sil type to LLVM type");
+    }
+}
+
+Type* type_named(CodegenContext* context, String name) {
+    Type* type = map_get(&context->types, name);
+    if (type != NULL && type->kind == TypeKind_Struct) {
+        return type;
+    }
+
+    AstNode* declaration = map_get(&context->struct_map, name);
+    if (declaration == NULL) {
+        sil_panic("Code Gen Error: Unknown type %.*s", name.length, name.data);
+    }
+
+    return layout_struct(context, declaration);
+}
+
+uint64_t type_size(CodegenContext* context, Type* type) {
+    if (type->kind == TypeKind_Struct || type->kind == TypeKind_Array) {
+        return type->size;
+    }
+    return LLVMABISizeOfType(LLVMGetModuleDataLayout(context->module), type->llvm_type);
+}
+
+unsigned int type_align(CodegenContext* context, Type* type) {
+    if (type->kind == TypeKind_Struct || type->kind == TypeKind_Array) {
+        return type->align;
+    }
+    return LLVMABIAlignmentOfType(LLVMGetModuleDataLayout(context->module), type->llvm_type);
+}
+
+StructField* type_field(Type* type, String name) {
+    for (int i = 0; i < type->fields.length; i++) {
+        StructField* field = list_get(StructField, &type->fields, i);
+        if (string_compare(field->name, name)) {
+            return field;
+        }
+    }
+
+    return NULL;
+}
+
+Type* type_element(Type* type) {
+    return type->kind == TypeKind_Vector ? type->child : type;
+}
+
+int type_coerces_to(Type* from, Type* to) {
+    if (from == to) {
+        return 1;
+    }
+
+    if (to->kind == TypeKind_Vector) {
+        if (from->kind == TypeKind_Vector) {
+            return from->lanes == to->lanes && type_coerces_to(from->child, to->child);
+        }
+        return type_coerces_to(from, to->child);
+    }
+
+    if (from->kind == TypeKind_Int && to->kind == TypeKind_Int) {
+        if (from->is_signed == to->is_signed) {
+            return to->bits >= from->bits;
+        }
+        return !from->is_signed && to->bits > from->bits;
+    }
+
+    if (from->kind == TypeKind_Float && to->kind == TypeKind_Float) {
+        return to->bits >= from->bits;
+    }
+
+    if (from->kind == TypeKind_Slice && to->kind == TypeKind_Slice) {
+        return from->child == to->child && to->is_const;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#ifndef CODEGEN_TYPE_H
+#define CODEGEN_TYPE_H
+
+#include "list.h"
+#include "parser/parser.h"
+#include "string_buffer.h"
+
+#include "llvm-c/Types.h"
+#include <stdint.h>
+
+typedef struct CodegenContext CodegenContext;
+
+typedef enum TypeKind {
+    TypeKind_Void,
+    TypeKind_Never,
+    TypeKind_Bool,
+    TypeKind_Int,
+    TypeKind_Float,
+    TypeKind_Pointer,
+    TypeKind_Vector,
+    TypeKind_Struct,
+    TypeKind_Array,
+    // a pointer to child and an element count
+    TypeKind_Slice,
+} TypeKind;
+
+typedef struct Type Type;
+
+typedef struct StructField {
+    String name;
+    Type* type;
+    uint64_t offset;
+    unsigned int align;
+    // element of the LLVM struct, which holds the padding as byte arrays
+    unsigned int index;
+} StructField;
+
+// Types are interned by name in the codegen context, so two types are the
+// same type exactly when their pointers are equal. A vector carries the bits
+// and signedness of its child, the lane type.
+struct Type {
+    TypeKind kind;
+    String name;
+    unsigned int bits;
+    int is_signed;
+    Type* child;
+    unsigned int lanes;
+    // element count of an array of child
+    unsigned int length;
+    // a @soa array keeps one array per field of its struct elements, and
+    // fields locates them like the fields of a struct
+    int is_soa;
+    // the elements of a []const slice are read only
+    int is_const;
+    LLVMTypeRef llvm_type;
+    // struct layout in memory order; align is 0 while it is being laid out
+    List fields;
+    uint64_t size;
+    unsigned int align;
+    // size the fields would take in declaration order
+    uint64_t declared_size;
+};
+
+typedef struct Value {
+    LLVMValueRef llvm_value;
+    Type* type;
+} Value;
+
+Type* type_void(CodegenContext* context);
+Type* type_never(CodegenContext* context);
+Type* type_bool(CodegenContext* context);
+Type* type_int(CodegenContext* context, unsigned int bits, int is_signed);
+Type* type_float(CodegenContext* context, unsigned int bits);
+Type* type_pointer(CodegenContext* context, Type* child);
+Type* type_vector(CodegenContext* context, Type* child, unsigned int lanes);
+Type* type_array(CodegenContext* context, Type* child, unsigned int length, int is_soa);
+Type* type_slice(CodegenContext* context, Type* child, int is_const);
+// Pointer sized unsigned integer of the target.
+Type* type_usize(CodegenContext* context);
+Type* type_from_ast(CodegenContext* context, AstNode* type_name);
+// A declared struct, laid out on first use.
+Type* type_named(CodegenContext* context, String name);
+
+// Bytes and alignment in memory, as the target lays them out.
+uint64_t type_size(CodegenContext* context, Type* type);
+unsigned int type_align(CodegenContext* context, Type* type);
+
+// The field of a struct with the given name, or NULL.
+StructField* type_field(Type* type, String name);
+
+// The lane type of a vector, otherwise the type itself.
+Type* type_element(Type* type);
+
+// Implicit conversions only widen, so they never lose a value. Scalars also
+// splat to vectors of a type they widen to, and a slice may become const.
+int type_coerces_to(Type* from, Type* to);
+
+#endif
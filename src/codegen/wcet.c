@@ -0,0 +1,955 @@
+#include "wcet.h"
+
+#include "codegen.h"
+#include "codegen/mca.h"
+#include "hashmap.h"
+#include "list.h"
+#include "util.h"
+
+#include "llvm-c/Core.h"
+#include "llvm-c/TargetMachine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+typedef enum TargetArch {
+    TargetArch_Other,
+    TargetArch_X86,
+    TargetArch_Arm,
+    TargetArch_AArch64,
+} TargetArch;
+
+typedef enum InstructionKind {
+    InstructionKind_Normal,
+    InstructionKind_Jump,
+    InstructionKind_ConditionalJump,
+    InstructionKind_Return,
+    InstructionKind_Call,
+    InstructionKind_TailCall,
+    InstructionKind_Indirect,
+} InstructionKind;
+
+typedef struct MachineBlock {
+    String label;
+    String ir_name;
+    List source;
+    List target_labels;
+    List calls;
+    int falls_through;
+    int has_indirect;
+    uint64_t cycles;
+    List successors;
+    List predecessors;
+} MachineBlock;
+
+typedef struct MachineFunction {
+    String name;
+    List blocks;
+} MachineFunction;
+
+typedef struct Wcet {
+    int visiting;
+    int bounded;
+    uint64_t cycles;
+    char reason[256];
+} Wcet;
+
+typedef struct MachineLoop {
+    int header;
+    List latches;
+    char* in_body;
+    int size;
+} MachineLoop;
+
+// An IR block of the optimized module tagged with !sil.loop.
+typedef struct LoopBlock {
+    String fn;
+    String block;
+    uint64_t trip_count;
+} LoopBlock;
+
+typedef struct WcetAnalysis {
+    CodegenContext* context;
+    TargetArch arch;
+    const char* comment;
+    List functions;
+    List loop_blocks;
+    HashMap results;
+} WcetAnalysis;
+
+static unsigned loop_kind(LLVMContextRef llvm_context) {
+    return LLVMGetMDKindIDInContext(llvm_context, "sil.loop", strlen("sil.loop"));
+}
+
+int wcet_add_loop(CodegenContext* context, uint64_t trip_count) {
+    if (!context->options->wcet) {
+        return -1;
+    }
+
+    LoopBound* bound = list_add(LoopBound, &context->loop_bounds);
+    bound->trip_count = trip_count;
+    return context->loop_bounds.length - 1;
+}
+
+void wcet_mark_loop_block(CodegenContext* context, LLVMBasicBlockRef block, int loop) {
+    LLVMValueRef terminator = LLVMGetBasicBlockTerminator(block);
+    if (loop < 0 || terminator == NULL) {
+        return;
+    }
+
+    LLVMContextRef llvm_context = LLVMGetModuleContext(context->module);
+    LLVMValueRef id = LLVMConstInt(LLVMInt64TypeInContext(llvm_context), loop, 0);
+    LLVMSetMetadata(terminator, loop_kind(llvm_context), LLVMMDNodeInContext(llvm_context, &id, 1));
+}
+
+// Names of the optimized blocks that still carry a !sil.loop tag. The names
+// survive into verbose assembly comments.
+static void collect_loop_blocks(WcetAnalysis* analysis) {
+    CodegenContext* context = analysis->context;
+    unsigned kind = loop_kind(LLVMGetModuleContext(context->module));
+
+    LLVMValueRef function = LLVMGetFirstFunction(context->module);
+    for (; function != NULL; function = LLVMGetNextFunction(function)) {
+        size_t length;
+        const char* fn_name = LLVMGetValueName2(function, &length);
+
+        LLVMBasicBlockRef block = LLVMGetFirstBasicBlock(function);
+        for (; block != NULL; block = LLVMGetNextBasicBlock(block)) {
+            LLVMValueRef terminator = LLVMGetBasicBlockTerminator(block);
+            LLVMValueRef tag = terminator != NULL ? LLVMGetMetadata(terminator, kind) : NULL;
+            if (tag == NULL) {
+                continue;
+            }
+
+            LLVMValueRef id;
+            LLVMGetMDNodeOperands(tag, &id);
+            LoopBound* bound = list_get(LoopBound, &context->loop_bounds, LLVMConstIntGetZExtValue(id));
+
+            const char* block_name = LLVMGetBasicBlockName(block);
+            LoopBlock* loop_block = list_add(LoopBlock, &analysis->loop_blocks);
+            loop_block->fn = string_from_buffer((char*)fn_name, length);
+            loop_block->block = string_from_buffer((char*)block_name, strlen(block_name));
+            loop_block->trip_count = bound->trip_count;
+        }
+    }
+}
+
+static TargetArch target_arch(CodegenContext* context) {
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    TargetArch arch = TargetArch_Other;
+    if (strncmp(triple, "x86_64", 6) == 0 || (triple[0] == 'i' && strncmp(triple + 2, "86", 2) == 0)) {
+        arch = TargetArch_X86;
+    } else if (strncmp(triple, "arm", 3) == 0 || strncmp(triple, "thumb", 5) == 0) {
+        arch = TargetArch_Arm;
+    } else if (strncmp(triple, "aarch64", 7) == 0 || strncmp(triple, "arm64", 5) == 0) {
+        arch = TargetArch_AArch64;
+    }
+    LLVMDisposeMessage(triple);
+
+    return arch;
+}
+
+static String trim(String text) {
+    while (text.length > 0 && (text.data[0] == ' ' || text.data[0] == '\t')) {
+        text.data += 1;
+        text.length -= 1;
+    }
+    while (text.length > 0 && (text.data[text.length - 1] == ' ' || text.data[text.length - 1] == '\t')) {
+        text.length -= 1;
+    }
+    return text;
+}
+
+static int text_is(String text, const char* literal) {
+    return text.length == strlen(literal) && strncmp(text.data, literal, text.length) == 0;
+}
+
+static int text_starts_with(String text, const char* literal) {
+    size_t length = strlen(literal);
+    return text.length >= length && strncmp(text.data, literal, length) == 0;
+}
+
+static String first_operand(String operands) {
+    String operand = trim(operands);
+    for (int i = 0; i < operand.length; i++) {
+        if (operand.data[i] == ',' || operand.data[i] == ' ' || operand.data[i] == '\t') {
+            operand.length = i;
+            break;
+        }
+    }
+    return operand;
+}
+
+// block label referenced by a branch, e.g. .LBB0_3
+static String branch_label(String operands) {
+    for (int i = 0; i + 3 < operands.length; i++) {
+        if (strncmp(operands.data + i, "LBB", 3) != 0) {
+            continue;
+        }
+
+        int start = i > 0 && operands.data[i - 1] == '.' ? i - 1 : i;
+        int end = i;
+        while (end < operands.length && operands.data[end] != ',' && operands.data[end] != ' ' && operands.data[end] != '\t') {
+            end++;
+        }
+        return (String){ operands.data + start, end - start };
+    }
+
+    return (String){ NULL, 0 };
+}
+
+static String call_target(String operands) {
+    String target = first_operand(operands);
+    for (int i = 0; i < target.length; i++) {
+        if (target.data[i] == '@') {
+            target.length = i;
+            break;
+        }
+    }
+    return target;
+}
+
+static int is_arm_condition(String text) {
+    const char* conditions[] = { "eq", "ne", "cs", "hs", "cc", "lo", "mi", "pl", "vs", "vc", "hi", "ls", "ge", "lt", "gt", "le" };
+    for (int i = 0; i < sizeof(conditions) / sizeof(conditions[0]); i++) {
+        if (text_is(text, conditions[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static InstructionKind classify_x86(String mnemonic, String operands) {
+    if (text_is(mnemonic, "jmp") || text_is(mnemonic, "jmpq")) {
+        if (trim(operands).data[0] == '*') {
+            return InstructionKind_Indirect;
+        }
+        return branch_label(operands).data != NULL ? InstructionKind_Jump : InstructionKind_TailCall;
+    }
+    if (mnemonic.data[0] == 'j') {
+        return InstructionKind_ConditionalJump;
+    }
+    if (text_is(mnemonic, "ret") || text_is(mnemonic, "retq")) {
+        return InstructionKind_Return;
+    }
+    if (text_is(mnemonic, "call") || text_is(mnemonic, "callq")) {
+        return trim(operands).data[0] == '*' ? InstructionKind_Indirect : InstructionKind_Call;
+    }
+    return InstructionKind_Normal;
+}
+
+static InstructionKind classify_arm(String mnemonic, String operands) {
+    // drop .w/.n width suffixes
+    if (mnemonic.length > 2 && mnemonic.data[mnemonic.length - 2] == '.') {
+        mnemonic.length -= 2;
+    }
+
+    if (text_is(mnemonic, "b")) {
+        return branch_label(operands).data != NULL ? InstructionKind_Jump : InstructionKind_TailCall;
+    }
+    if (text_is(mnemonic, "cbz") || text_is(mnemonic, "cbnz")
+        || (mnemonic.length == 3 && mnemonic.data[0] == 'b' && is_arm_condition((String){ mnemonic.data + 1, 2 }))) {
+        return InstructionKind_ConditionalJump;
+    }
+    if (text_is(mnemonic, "bl")) {
+        return InstructionKind_Call;
+    }
+    if (text_is(mnemonic, "bx")) {
+        return text_is(first_operand(operands), "lr") ? InstructionKind_Return : InstructionKind_Indirect;
+    }
+    if (text_is(mnemonic, "blx") || text_is(mnemonic, "tbb") || text_is(mnemonic, "tbh")) {
+        return InstructionKind_Indirect;
+    }
+    if (text_is(mnemonic, "pop") || text_starts_with(mnemonic, "ldm")) {
+        for (int i = 0; i + 1 < operands.length; i++) {
+            if (operands.data[i] == 'p' && operands.data[i + 1] == 'c') {
+                return InstructionKind_Return;
+            }
+        }
+    }
+    return InstructionKind_Normal;
+}
+
+static InstructionKind classify_aarch64(String mnemonic, String operands) {
+    if (text_is(mnemonic, "b")) {
+        return branch_label(operands).data != NULL ? InstructionKind_Jump : InstructionKind_TailCall;
+    }
+    if (text_starts_with(mnemonic, "b.") || text_is(mnemonic, "cbz") || text_is(mnemonic, "cbnz")
+        || text_is(mnemonic, "tbz") || text_is(mnemonic, "tbnz")) {
+        return InstructionKind_ConditionalJump;
+    }
+    if (text_is(mnemonic, "ret")) {
+        return InstructionKind_Return;
+    }
+    if (text_is(mnemonic, "bl")) {
+        return InstructionKind_Call;
+    }
+    if (text_is(mnemonic, "br") || text_is(mnemonic, "blr")) {
+        return InstructionKind_Indirect;
+    }
+    return InstructionKind_Normal;
+}
+
+static InstructionKind classify(WcetAnalysis* analysis, String mnemonic, String operands) {
+    switch (analysis->arch) {
+        case TargetArch_X86: return classify_x86(mnemonic, operands);
+        case TargetArch_Arm: return classify_arm(mnemonic, operands);
+        case TargetArch_AArch64: return classify_aarch64(mnemonic, operands);
+        default: sil_panic("WCET Error: Unsupported target");
+    }
+}
+
+// llvm-mca charges calls a fixed 100 cycles, so they are costed as the
+// taken branch they are and the callee is added separately
+static const char* call_as_branch(WcetAnalysis* analysis) {
+    switch (analysis->arch) {
+        case TargetArch_X86: return "jmp";
+        case TargetArch_Arm: return "b.w";
+        default: return "b";
+    }
+}
+
+// IR block name from a verbose asm comment such as "# %for.body"
+static String block_ir_name(WcetAnalysis* analysis, String line) {
+    size_t prefix_length = strlen(analysis->comment);
+    String name = { NULL, 0 };
+
+    for (int i = 0; i + prefix_length + 1 < line.length; i++) {
+        if (strncmp(line.data + i, analysis->comment, prefix_length) != 0) {
+            continue;
+        }
+
+        String rest = trim((String){ line.data + i + prefix_length, line.length - i - prefix_length });
+        if (rest.length > 1 && rest.data[0] == '%' && !text_starts_with(rest, "%bb.")) {
+            name = first_operand((String){ rest.data + 1, rest.length - 1 });
+        }
+    }
+
+    return name;
+}
+
+static MachineBlock* begin_block(MachineFunction* function, String label) {
+    MachineBlock* current = function->blocks.length > 0
+        ? list_get(MachineBlock, &function->blocks, function->blocks.length - 1)
+        : NULL;
+
+    // the entry block's "%bb.0:" comment follows the function label
+    if (current != NULL && current->source.length == 0 && current->label.data == NULL
+        && function->blocks.length == 1 && label.data == NULL) {
+        return current;
+    }
+
+    MachineBlock* block = list_add(MachineBlock, &function->blocks);
+    memset(block, 0, sizeof(MachineBlock));
+    block->label = label;
+    block->falls_through = 1;
+
+    return block;
+}
+
+static void add_instruction(WcetAnalysis* analysis, MachineBlock* block, String text) {
+    // strip the trailing comment
+    for (int i = 0; i < text.length; i++) {
+        if (strncmp(text.data + i, analysis->comment, strlen(analysis->comment)) == 0) {
+            text.length = i;
+            break;
+        }
+    }
+    text = trim(text);
+    if (text.length == 0) {
+        return;
+    }
+
+    String mnemonic = first_operand(text);
+    String operands = trim((String){ mnemonic.data + mnemonic.length, text.length - mnemonic.length });
+    InstructionKind kind = classify(analysis, mnemonic, operands);
+
+    String source = text;
+    switch (kind) {
+        case InstructionKind_Jump: {
+            String label = branch_label(operands);
+            list_push(String, &block->target_labels, &label);
+            block->falls_through = 0;
+            break;
+        }
+        case InstructionKind_ConditionalJump: {
+            String label = branch_label(operands);
+            if (label.data != NULL) {
+                list_push(String, &block->target_labels, &label);
+            }
+            break;
+        }
+        case InstructionKind_Return:
+            block->falls_through = 0;
+            break;
+        case InstructionKind_Call: {
+            String target = call_target(operands);
+            list_push(String, &block->calls, &target);
+
+            const char* branch = call_as_branch(analysis);
+            mca_append_text(&block->source, branch, strlen(branch));
+            mca_append_text(&block->source, " ", 1);
+            mca_append_text(&block->source, operands.data, operands.length);
+            mca_append_text(&block->source, "\n", 1);
+            return;
+        }
+        case InstructionKind_TailCall: {
+            String target = call_target(operands);
+            list_push(String, &block->calls, &target);
+            block->falls_through = 0;
+            break;
+        }
+        case InstructionKind_Indirect:
+            block->has_indirect = 1;
+            break;
+        default:
+            break;
+    }
+
+    mca_append_text(&block->source, source.data, source.length);
+    mca_append_text(&block->source, "\n", 1);
+}
+
+static int is_label_line(String text) {
+    String first = first_operand(text);
+    return first.length > 0 && first.data[first.length - 1] == ':';
+}
+
+static int parse_function(WcetAnalysis* analysis, char* assembly, String name, MachineFunction* function) {
+    function->name = name;
+    function->blocks = (List){0};
+
+    int in_function = 0;
+    MachineBlock* block = NULL;
+
+    char* line = assembly;
+    while (*line != 0) {
+        char* line_end = strchr(line, '\n');
+        if (line_end == NULL) {
+            line_end = line + strlen(line);
+        }
+        String text = trim((String){ line, line_end - line });
+        line = *line_end == 0 ? line_end : line_end + 1;
+
+        if (!in_function) {
+            String label = first_operand(text);
+            if (label.length == name.length + 1 && strncmp(label.data, name.data, name.length) == 0
+                && label.data[name.length] == ':') {
+                in_function = 1;
+                block = begin_block(function, (String){ NULL, 0 });
+            }
+            continue;
+        }
+
+        if (text_starts_with(text, ".Lfunc_end") || text_starts_with(text, "Lfunc_end")) {
+            return 1;
+        }
+
+        if (text.length == 0) {
+            continue;
+        }
+
+        if (text_starts_with(text, analysis->comment)) {
+            String rest = trim((String){ text.data + strlen(analysis->comment), text.length - strlen(analysis->comment) });
+            if (text_starts_with(rest, "%bb.")) {
+                block = begin_block(function, (String){ NULL, 0 });
+                block->ir_name = block_ir_name(analysis, rest);
+            }
+            continue;
+        }
+
+        if (is_label_line(text)) {
+            String label = first_operand(text);
+            label.length -= 1;
+            if (branch_label(label).data != NULL) {
+                block = begin_block(function, label);
+                block->ir_name = block_ir_name(analysis, text);
+            }
+            continue;
+        }
+
+        if (text.data[0] == '.') {
+            continue;
+        }
+
+        add_instruction(analysis, block, text);
+    }
+
+    return in_function;
+}
+
+static void link_blocks(MachineFunction* function) {
+    List* blocks = &function->blocks;
+    for (int i = 0; i < blocks->length; i++) {
+        MachineBlock* block = list_get(MachineBlock, blocks, i);
+
+        for (int j = 0; j < block->target_labels.length; j++) {
+            String label = *list_get(String, &block->target_labels, j);
+            for (int k = 0; k < blocks->length; k++) {
+                MachineBlock* target = list_get(MachineBlock, blocks, k);
+                if (target->label.data != NULL && string_compare(target->label, label)) {
+                    list_push(int, &block->successors, &k);
+                }
+            }
+        }
+
+        if (block->falls_through && i + 1 < blocks->length) {
+            int next = i + 1;
+            list_push(int, &block->successors, &next);
+        }
+    }
+
+    for (int i = 0; i < blocks->length; i++) {
+        MachineBlock* block = list_get(MachineBlock, blocks, i);
+        for (int j = 0; j < block->successors.length; j++) {
+            int successor = *list_get(int, &block->successors, j);
+            MachineBlock* target = list_get(MachineBlock, blocks, successor);
+            list_push(int, &target->predecessors, &i);
+        }
+    }
+}
+
+// One llvm-mca run with a single-iteration region per machine block.
+static void measure_blocks(WcetAnalysis* analysis, char* assembly) {
+    List source = {0};
+
+    char* line = assembly;
+    while (*line != 0) {
+        char* line_end = strchr(line, '\n');
+        if (line_end == NULL) {
+            line_end = line + strlen(line);
+        }
+        String text = trim((String){ line, line_end - line });
+        if (mca_is_mode_directive(text.data)) {
+            mca_append_text(&source, text.data, text.length);
+            mca_append_text(&source, "\n", 1);
+        }
+        line = *line_end == 0 ? line_end : line_end + 1;
+    }
+
+    int region_count = 0;
+    for (int i = 0; i < analysis->functions.length; i++) {
+        MachineFunction* function = list_get(MachineFunction, &analysis->functions, i);
+        for (int j = 0; j < function->blocks.length; j++) {
+            MachineBlock* block = list_get(MachineBlock, &function->blocks, j);
+            if (block->source.length == 0) {
+                continue;
+            }
+
+            char region[64];
+            int region_length = snprintf(region, sizeof(region), "f%db%d", i, j);
+            mca_append_marker(analysis->context, &source, "LLVM-MCA-BEGIN", (String){ region, region_length });
+            mca_append_text(&source, block->source.data, block->source.length);
+            mca_append_marker(analysis->context, &source, "LLVM-MCA-END", (String){ region, region_length });
+            region_count += 1;
+        }
+    }
+
+    if (region_count == 0) {
+        list_delete(&source);
+        return;
+    }
+
+    const char* arguments[] = { "-iterations=1", NULL };
+    FILE* output = mca_run(analysis->context, &source, arguments);
+
+    MachineBlock* block = NULL;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), output) != NULL) {
+        int region_index;
+        int function_index;
+        int block_index;
+        unsigned long long cycles;
+        if (sscanf(buffer, "[%d] Code Region - f%db%d", &region_index, &function_index, &block_index) == 3) {
+            MachineFunction* function = list_get(MachineFunction, &analysis->functions, function_index);
+            block = list_get(MachineBlock, &function->blocks, block_index);
+        } else if (block != NULL && sscanf(buffer, "Total Cycles: %llu", &cycles) == 1) {
+            block->cycles = cycles;
+            block = NULL;
+        }
+    }
+
+    fclose(output);
+    list_delete(&source);
+}
+
+static MachineFunction* find_function(WcetAnalysis* analysis, String name) {
+    for (int i = 0; i < analysis->functions.length; i++) {
+        MachineFunction* function = list_get(MachineFunction, &analysis->functions, i);
+        if (string_compare(function->name, name)) {
+            return function;
+        }
+    }
+    return NULL;
+}
+
+// Trip count of the loop an optimized block belongs to.
+static int find_loop_bound(WcetAnalysis* analysis, String fn, String block, uint64_t* trip_count) {
+    if (block.data == NULL) {
+        return 0;
+    }
+
+    List* loop_blocks = &analysis->loop_blocks;
+    for (int i = 0; i < loop_blocks->length; i++) {
+        LoopBlock* loop_block = list_get(LoopBlock, loop_blocks, i);
+        if (!string_compare(loop_block->fn, fn) || !string_compare(loop_block->block, block)) {
+            continue;
+        }
+        if (loop_block->trip_count == WCET_UNBOUNDED) {
+            return 0;
+        }
+
+        *trip_count = loop_block->trip_count;
+        return 1;
+    }
+
+    return 0;
+}
+
+static int find_representative(int* representatives, int block) {
+    while (representatives[block] != block) {
+        block = representatives[block];
+    }
+    return block;
+}
+
+typedef struct PathState {
+    MachineFunction* function;
+    int* representatives;
+    uint64_t* longest;
+    char* state;
+    MachineLoop* loop;
+    int cyclic;
+} PathState;
+
+// Longest path over the collapsed graph. Inside a loop the path ends at the
+// back edge or where it leaves the body.
+static uint64_t longest_path(PathState* path, int block_index) {
+    if (path->state[block_index] == 2) {
+        return path->longest[block_index];
+    }
+    if (path->state[block_index] == 1) {
+        path->cyclic = 1;
+        return 0;
+    }
+    path->state[block_index] = 1;
+
+    uint64_t deepest = 0;
+    List* blocks = &path->function->blocks;
+    for (int i = 0; i < blocks->length; i++) {
+        if (find_representative(path->representatives, i) != block_index) {
+            continue;
+        }
+
+        MachineBlock* member = list_get(MachineBlock, blocks, i);
+        for (int j = 0; j < member->successors.length; j++) {
+            int successor = find_representative(path->representatives, *list_get(int, &member->successors, j));
+            if (successor == block_index) {
+                continue;
+            }
+            if (path->loop != NULL && (successor == path->loop->header || !path->loop->in_body[successor])) {
+                continue;
+            }
+
+            uint64_t depth = longest_path(path, successor);
+            if (depth > deepest) {
+                deepest = depth;
+            }
+        }
+    }
+
+    path->state[block_index] = 2;
+    MachineBlock* block = list_get(MachineBlock, blocks, block_index);
+    path->longest[block_index] = block->cycles + deepest;
+    return path->longest[block_index];
+}
+
+static List find_loops(MachineFunction* function) {
+    List loops = {0};
+    List* blocks = &function->blocks;
+    int count = blocks->length;
+
+    // depth first search for back edges
+    char* state = calloc(count, 1);
+    int* stack = malloc(sizeof(int) * count);
+    int* next_successor = calloc(count, sizeof(int));
+    int depth = 0;
+    stack[depth++] = 0;
+    state[0] = 1;
+
+    while (depth > 0) {
+        int block_index = stack[depth - 1];
+        MachineBlock* block = list_get(MachineBlock, blocks, block_index);
+        if (next_successor[block_index] == block->successors.length) {
+            state[block_index] = 2;
+            depth -= 1;
+            continue;
+        }
+
+        int successor = *list_get(int, &block->successors, next_successor[block_index]);
+        next_successor[block_index] += 1;
+
+        if (state[successor] == 0) {
+            state[successor] = 1;
+            stack[depth++] = successor;
+        } else if (state[successor] == 1) {
+            MachineLoop* loop = NULL;
+            for (int i = 0; i < loops.length; i++) {
+                MachineLoop* existing = list_get(MachineLoop, &loops, i);
+                if (existing->header == successor) {
+                    loop = existing;
+                }
+            }
+            if (loop == NULL) {
+                loop = list_add(MachineLoop, &loops);
+                memset(loop, 0, sizeof(MachineLoop));
+                loop->header = successor;
+                loop->in_body = calloc(count, 1);
+                loop->in_body[successor] = 1;
+                loop->size = 1;
+            }
+            list_push(int, &loop->latches, &block_index);
+        }
+    }
+
+    // natural loop bodies: everything reaching a latch without passing the header
+    for (int i = 0; i < loops.length; i++) {
+        MachineLoop* loop = list_get(MachineLoop, &loops, i);
+        int work_length = 0;
+        for (int j = 0; j < loop->latches.length; j++) {
+            int latch = *list_get(int, &loop->latches, j);
+            if (!loop->in_body[latch]) {
+                loop->in_body[latch] = 1;
+                loop->size += 1;
+                stack[work_length++] = latch;
+            }
+        }
+
+        while (work_length > 0) {
+            MachineBlock* block = list_get(MachineBlock, blocks, stack[--work_length]);
+            for (int j = 0; j < block->predecessors.length; j++) {
+                int predecessor = *list_get(int, &block->predecessors, j);
+                if (!loop->in_body[predecessor]) {
+                    loop->in_body[predecessor] = 1;
+                    loop->size += 1;
+                    stack[work_length++] = predecessor;
+                }
+            }
+        }
+    }
+
+    free(state);
+    free(stack);
+    free(next_successor);
+
+    return loops;
+}
+
+static int compare_loop_size(const void* a, const void* b) {
+    return ((const MachineLoop*)a)->size - ((const MachineLoop*)b)->size;
+}
+
+static String block_display_name(MachineBlock* block) {
+    if (block->ir_name.data != NULL) {
+        return block->ir_name;
+    }
+    if (block->label.data != NULL) {
+        return block->label;
+    }
+    return string_from_literal("entry");
+}
+
+static Wcet* function_wcet(WcetAnalysis* analysis, String name);
+
+static void analyze_function(WcetAnalysis* analysis, MachineFunction* function, Wcet* result) {
+    List* blocks = &function->blocks;
+    int count = blocks->length;
+
+    for (int i = 0; i < count; i++) {
+        MachineBlock* block = list_get(MachineBlock, blocks, i);
+        if (block->has_indirect) {
+            snprintf(result->reason, sizeof(result->reason), "indirect branch or call");
+            return;
+        }
+
+        for (int j = 0; j < block->calls.length; j++) {
+            String callee_name = *list_get(String, &block->calls, j);
+            Wcet* callee = function_wcet(analysis, callee_name);
+            if (callee->visiting) {
+                snprintf(result->reason, sizeof(result->reason), "recursion through %.*s", callee_name.length, callee_name.data);
+                return;
+            }
+            if (!callee->bounded) {
+                // the callee's reason is cut short rather than the caller's
+                int room = (int)sizeof(result->reason) - (int)strlen("calls : ") - (int)callee_name.length - 1;
+                snprintf(
+                    result->reason,
+                    sizeof(result->reason),
+                    "calls %.*s: %.*s",
+                    callee_name.length,
+                    callee_name.data,
+                    room > 0 ? room : 0,
+                    callee->reason
+                );
+                return;
+            }
+            block->cycles += callee->cycles;
+        }
+    }
+
+    int* representatives = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        representatives[i] = i;
+    }
+
+    PathState path = {0};
+    path.function = function;
+    path.representatives = representatives;
+    path.longest = malloc(sizeof(uint64_t) * count);
+    path.state = malloc(count);
+
+    // innermost loops first; each collapses into its header
+    List loops = find_loops(function);
+    qsort(loops.data, loops.length, sizeof(MachineLoop), compare_loop_size);
+
+    for (int i = 0; i < loops.length && result->reason[0] == 0; i++) {
+        MachineLoop* loop = list_get(MachineLoop, &loops, i);
+        MachineBlock* header = list_get(MachineBlock, blocks, loop->header);
+
+        uint64_t trip_count;
+        int bounded = find_loop_bound(analysis, function->name, header->ir_name, &trip_count);
+        for (int j = 0; j < loop->latches.length && !bounded; j++) {
+            MachineBlock* latch = list_get(MachineBlock, blocks, *list_get(int, &loop->latches, j));
+            bounded = find_loop_bound(analysis, function->name, latch->ir_name, &trip_count);
+        }
+
+        if (!bounded) {
+            String header_name = block_display_name(header);
+            snprintf(
+                result->reason,
+                sizeof(result->reason),
+                "loop at %.*s has no compile-time bound",
+                header_name.length,
+                header_name.data
+            );
+            break;
+        }
+
+        memset(path.state, 0, count);
+        path.loop = loop;
+        uint64_t iteration = longest_path(&path, loop->header);
+
+        // the header runs once more to leave the loop
+        header->cycles = (trip_count + 1) * iteration;
+        for (int j = 0; j < count; j++) {
+            if (loop->in_body[j] && find_representative(representatives, j) != loop->header) {
+                representatives[find_representative(representatives, j)] = loop->header;
+            }
+        }
+    }
+
+    if (result->reason[0] == 0) {
+        memset(path.state, 0, count);
+        path.loop = NULL;
+        result->cycles = longest_path(&path, 0);
+
+        if (path.cyclic) {
+            snprintf(result->reason, sizeof(result->reason), "irreducible control flow");
+        } else {
+            result->bounded = 1;
+        }
+    }
+
+    for (int i = 0; i < loops.length; i++) {
+        MachineLoop* loop = list_get(MachineLoop, &loops, i);
+        free(loop->in_body);
+        list_delete(&loop->latches);
+    }
+    list_delete(&loops);
+    free(representatives);
+    free(path.longest);
+    free(path.state);
+}
+
+static Wcet* function_wcet(WcetAnalysis* analysis, String name) {
+    Wcet* result = map_get(&analysis->results, name);
+    if (result != NULL) {
+        return result;
+    }
+
+    result = calloc(1, sizeof(Wcet));
+    map_insert(&analysis->results, name, result);
+
+    AstNode* fn = map_get(&analysis->context->function_map, name);
+    MachineFunction* function = find_function(analysis, name);
+    if (fn == NULL) {
+        snprintf(result->reason, sizeof(result->reason), "runtime routine %.*s has unknown cost", name.length, name.data);
+    } else if (fn->type == AstNodeType_ExternFn) {
+        snprintf(result->reason, sizeof(result->reason), "extern fn %.*s has unknown cost", name.length, name.data);
+    } else if (function == NULL) {
+        snprintf(result->reason, sizeof(result->reason), "not emitted, inlined into every caller");
+    } else {
+        result->visiting = 1;
+        analyze_function(analysis, function, result);
+        result->visiting = 0;
+    }
+
+    return result;
+}
+
+void wcet_print(CodegenContext* context) {
+    if (!context->options->wcet) {
+        return;
+    }
+
+    WcetAnalysis analysis = {0};
+    analysis.context = context;
+    analysis.arch = target_arch(context);
+    analysis.comment = mca_comment_prefix(context);
+
+    char* triple = LLVMGetTargetMachineTriple(context->target_machine);
+    char* cpu = LLVMGetTargetMachineCPU(context->target_machine);
+    printf("\nWCET estimate (%s, %s)\n\n", triple, cpu);
+    LLVMDisposeMessage(triple);
+    LLVMDisposeMessage(cpu);
+
+    if (analysis.arch == TargetArch_Other) {
+        printf("not supported for this target\n");
+        return;
+    }
+
+    collect_loop_blocks(&analysis);
+    char* assembly = mca_emit_assembly(context);
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used || ((AstNode*)entry->value)->type != AstNodeType_Fn) {
+            continue;
+        }
+
+        MachineFunction function;
+        if (parse_function(&analysis, assembly, entry->key, &function)) {
+            link_blocks(&function);
+            list_push(MachineFunction, &analysis.functions, &function);
+        }
+    }
+
+    measure_blocks(&analysis, assembly);
+
+    printf("%-32s %s\n", "function", "cycles (upper bound)");
+    for (int i = 0; i < context->function_map.entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &context->function_map.entries, i);
+        if (!entry->used || ((AstNode*)entry->value)->type != AstNodeType_Fn) {
+            continue;
+        }
+
+        Wcet* result = function_wcet(&analysis, entry->key);
+        if (result->bounded) {
+            printf("%-32.*s %llu\n", entry->key.length, entry->key.data, (unsigned long long)result->cycles);
+        } else {
+            printf("%-32.*s unbounded: %s\n", entry->key.length, entry->key.data, result->reason);
+        }
+    }
+
+    free(assembly);
+}
@@ -0,0 +1,32 @@
+#ifndef CODEGEN_WCET_H
+#define CODEGEN_WCET_H
+
+#include "string_buffer.h"
+
+#include "llvm-c/Core.h"
+#include <stdint.h>
+
+typedef struct CodegenContext CodegenContext;
+
+// Trip count of a loop whose range is not constant.
+#define WCET_UNBOUNDED UINT64_MAX
+
+// Trip count of a loop known at compile time. Loops are numbered by their
+// index in context->loop_bounds.
+typedef struct LoopBound {
+    uint64_t trip_count;
+} LoopBound;
+
+// Records the trip count of a new loop, or WCET_UNBOUNDED, and returns its
+// number. Returns -1 without --wcet.
+int wcet_add_loop(CodegenContext* context, uint64_t trip_count);
+
+// Tags the terminator of a loop block with !sil.loop N. Inlining and
+// unrolling copy the tag along with the block, so the copies still find
+// their loop after the block names have changed.
+void wcet_mark_loop_block(CodegenContext* context, LLVMBasicBlockRef block, int loop);
+
+// Prints an upper bound on cycles per sil function, or why there is none.
+void wcet_print(CodegenContext* context);
+
+#endif
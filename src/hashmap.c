@@ -7,32 +7,37 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-static size_t hash_function(String string) {
-    // FNV 32-bit hash
-    unsigned int h = 2166136261;
-    for (int i = 0; i < string.length; i += 1) {
-        h = h ^ ((unsigned char)*(string.data + i));
-        h = h * 16777619;
+void map_delete(HashMap* map) {
+    list_delete(&map->entries);
+}
+
+static void map_grow(HashMap* map) {
+    List old_entries = map->entries;
+
+    map->entries = (List){0};
+    list_resize(Entry, &map->entries, old_entries.capacity * 2 + 8);
+    for (int i = 0; i < map->entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &map->entries, i);
+        entry->used = 0;
     }
 
-    return h;
-}
+    // probe sequences depend on the capacity so every entry is reinserted
+    for (int i = 0; i < old_entries.capacity; i++) {
+        Entry* entry = list_get(Entry, &old_entries, i);
+        if (entry->used) {
+            map_insert(map, entry->key, entry->value);
+        }
+    }
 
-void map_delete(HashMap* map) {
-    list_delete(&map->entries);
+    list_delete(&old_entries);
 }
 
 void map_insert(HashMap* map, String key, void* value) {
     if (map->entries.length * 5 >= map->entries.capacity * 4) {
-        size_t old_capacity = map->entries.capacity;
-        list_resize(Entry, &map->entries, map->entries.capacity * 2 + 8);
-        for (int i = old_capacity; i < map->entries.capacity; i++) {
-            Entry* entry = list_get(Entry, &map->entries, i);
-            entry->used = 0;
-        }
+        map_grow(map);
     }
 
-    size_t start_index = hash_function(key);
+    size_t start_index = string_hash(key);
     for (int i = 0; i < map->entries.capacity; i++) {
         size_t index = (start_index + i) % map->entries.capacity;
         Entry* entry = list_get(Entry, &map->entries, index);
@@ -54,10 +59,13 @@ void map_insert(HashMap* map, String key, void* value) {
 }
 
 void* map_get(HashMap* map, String key) {
-    size_t start_index = hash_function(key);
+    size_t start_index = string_hash(key);
     for (int i = 0; i < map->entries.capacity; i++) {
         size_t index = (start_index + i) % map->entries.capacity;
         Entry* entry = list_get(Entry, &map->entries, index);
+        if (!entry->used) {
+            return NULL;
+        }
         if (string_compare(key, entry->key)) {
             return entry->value;
         }
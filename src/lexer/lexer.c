@@ -37,6 +37,13 @@ typedef enum LexerState {
     TokenizerState_Number,
     TokenizerState_String,
     TokenizerState_Dash,
+    TokenizerState_Plus,
+    TokenizerState_Star,
+    TokenizerState_Equals,
+    TokenizerState_Bang,
+    TokenizerState_Less,
+    TokenizerState_Greater,
+    TokenizerState_Dot,
     TokenizerState_Slash,
     TokenizerState_Comment,
     TokenizerState_MultilineComment,
@@ -75,6 +82,8 @@ static void end_token(TokenizerContext* context) {
             token->type = TokenType_KeywordReturn;
         } else if (token_symbol_compare(context->source, token, "let")) {
             token->type = TokenType_KeywordLet;
+        } else if (token_symbol_compare(context->source, token, "mut")) {
+            token->type = TokenType_KeywordMut;
         } else if (token_symbol_compare(context->source, token, "extern")) {
             token->type = TokenType_KeywordExtern;
         } else if (token_symbol_compare(context->source, token, "if")) {
@@ -85,6 +94,26 @@ static void end_token(TokenizerContext* context) {
             token->type = TokenType_KeywordTrue;
         } else if (token_symbol_compare(context->source, token, "false")) {
             token->type = TokenType_KeywordFalse;
+        } else if (token_symbol_compare(context->source, token, "for")) {
+            token->type = TokenType_KeywordFor;
+        } else if (token_symbol_compare(context->source, token, "in")) {
+            token->type = TokenType_KeywordIn;
+        } else if (token_symbol_compare(context->source, token, "while")) {
+            token->type = TokenType_KeywordWhile;
+        } else if (token_symbol_compare(context->source, token, "loop")) {
+            token->type = TokenType_KeywordLoop;
+        } else if (token_symbol_compare(context->source, token, "break")) {
+            token->type = TokenType_KeywordBreak;
+        } else if (token_symbol_compare(context->source, token, "continue")) {
+            token->type = TokenType_KeywordContinue;
+        } else if (token_symbol_compare(context->source, token, "volatile")) {
+            token->type = TokenType_KeywordVolatile;
+        } else if (token_symbol_compare(context->source, token, "asm")) {
+            token->type = TokenType_KeywordAsm;
+        } else if (token_symbol_compare(context->source, token, "tail")) {
+            token->type = TokenType_KeywordTail;
+        } else if (token_symbol_compare(context->source, token, "struct")) {
+            token->type = TokenType_KeywordStruct;
         }
     }
 }
@@ -104,8 +133,11 @@ List tokenize(String source) {
 
                     case WHITESPACE:
                         break;
+                    // @name is a builtin and #name a loop hint
                     case ALPHA:
                     case '_':
+                    case '@':
+                    case '#':
                         begin_token(&context, TokenType_Symbol);
                         context.state = TokenizerState_Symbol;
                         break;
@@ -135,7 +167,7 @@ List tokenize(String source) {
                         break;
                     case '*':
                         begin_token(&context, TokenType_Star);
-                        end_token(&context);
+                        context.state = TokenizerState_Star;
                         break;
                     case '{':
                         begin_token(&context, TokenType_LBrace);
@@ -153,21 +185,53 @@ List tokenize(String source) {
                         begin_token(&context, TokenType_RParen);
                         end_token(&context);
                         break;
+                    case '[':
+                        begin_token(&context, TokenType_LBracket);
+                        end_token(&context);
+                        break;
+                    case ']':
+                        begin_token(&context, TokenType_RBracket);
+                        end_token(&context);
+                        break;
+                    case '.':
+                        begin_token(&context, TokenType_Dot);
+                        context.state = TokenizerState_Dot;
+                        break;
                     case '~':
                         begin_token(&context, TokenType_Tilde);
                         end_token(&context);
                         break;
                     case '!':
                         begin_token(&context, TokenType_Bang);
-                        end_token(&context);
+                        context.state = TokenizerState_Bang;
                         break;
                     case '=':
                         begin_token(&context, TokenType_Equals);
+                        context.state = TokenizerState_Equals;
+                        break;
+                    case '<':
+                        begin_token(&context, TokenType_Less);
+                        context.state = TokenizerState_Less;
+                        break;
+                    case '>':
+                        begin_token(&context, TokenType_Greater);
+                        context.state = TokenizerState_Greater;
+                        break;
+                    case '%':
+                        begin_token(&context, TokenType_Percent);
+                        end_token(&context);
+                        break;
+                    case '|':
+                        begin_token(&context, TokenType_Pipe);
+                        end_token(&context);
+                        break;
+                    case '^':
+                        begin_token(&context, TokenType_Caret);
                         end_token(&context);
                         break;
                     case '+':
                         begin_token(&context, TokenType_Plus);
-                        end_token(&context);
+                        context.state = TokenizerState_Plus;
                         break;
                     case '-':
                         begin_token(&context, TokenType_Dash);
@@ -198,7 +262,23 @@ List tokenize(String source) {
 
             case TokenizerState_Number:
                 switch (current_char) {
+                    // letters cover 0x/0b prefixes and hex digits
                     case DIGIT:
+                    case ALPHA:
+                    case '_':
+                        break;
+                    case '.':
+                        // a fraction, not the start of a range
+                        if (context.offset + 1 < source.length) {
+                            char next_char = get_char(&context, context.offset + 1);
+                            if (next_char >= '0' && next_char <= '9') {
+                                break;
+                            }
+                        }
+                        context.offset -= 1;
+                        context.position.column -= 1;
+                        end_token(&context);
+                        context.state = TokenizerState_Start;
                         break;
                     default:
                         context.offset -= 1;
@@ -215,25 +295,81 @@ List tokenize(String source) {
                         end_token(&context);
                         context.state = TokenizerState_Start;
                         break;
+                    // an escaped quote does not end the string
+                    case '\\':
+                        context.offset += 1;
+                        context.position.column += 1;
+                        break;
                     default: break;
                 }
                 break;
 
             case TokenizerState_Dash:
-                switch (current_char) {
-                    case '>':
-                        context.current_token->type = TokenType_Arrow;
-                        end_token(&context);
-                        context.state = TokenizerState_Start;
-                        break;
-                    default:
-                        context.offset -= 1;
-                        context.position.column -= 1;
-                        end_token(&context);
-                        context.state = TokenizerState_Start;
-                        break;
+            case TokenizerState_Plus:
+            case TokenizerState_Star: {
+                TokenType type = context.current_token->type;
+                if (current_char == '>' && type == TokenType_Dash) {
+                    type = TokenType_Arrow;
+                } else if (current_char == '%') {
+                    switch (type) {
+                        case TokenType_Plus: type = TokenType_PlusPercent; break;
+                        case TokenType_Dash: type = TokenType_DashPercent; break;
+                        default: type = TokenType_StarPercent; break;
+                    }
+                } else if (current_char == '|') {
+                    switch (type) {
+                        case TokenType_Plus: type = TokenType_PlusPipe; break;
+                        case TokenType_Dash: type = TokenType_DashPipe; break;
+                        default: type = TokenType_StarPipe; break;
+                    }
+                } else {
+                    context.offset -= 1;
+                    context.position.column -= 1;
+                }
+
+                context.current_token->type = type;
+                end_token(&context);
+                context.state = TokenizerState_Start;
+                break;
+            }
+
+            case TokenizerState_Dot:
+                if (current_char == '.') {
+                    context.current_token->type = TokenType_DotDot;
+                } else {
+                    context.offset -= 1;
+                    context.position.column -= 1;
                 }
+                end_token(&context);
+                context.state = TokenizerState_Start;
+                break;
+
+            case TokenizerState_Equals:
+            case TokenizerState_Bang:
+            case TokenizerState_Less:
+            case TokenizerState_Greater: {
+                TokenType type = context.current_token->type;
+                if (current_char == '=') {
+                    switch (type) {
+                        case TokenType_Equals: type = TokenType_EqualsEquals; break;
+                        case TokenType_Bang: type = TokenType_BangEquals; break;
+                        case TokenType_Less: type = TokenType_LessEquals; break;
+                        default: type = TokenType_GreaterEquals; break;
+                    }
+                } else if (current_char == '<' && type == TokenType_Less) {
+                    type = TokenType_ShiftLeft;
+                } else if (current_char == '>' && type == TokenType_Greater) {
+                    type = TokenType_ShiftRight;
+                } else {
+                    context.offset -= 1;
+                    context.position.column -= 1;
+                }
+
+                context.current_token->type = type;
+                end_token(&context);
+                context.state = TokenizerState_Start;
                 break;
+            }
 
             case TokenizerState_Slash:
                 if (current_char == '*') {
@@ -284,7 +420,8 @@ List tokenize(String source) {
 }
 
 int token_symbol_compare(String source, Token* token, char* symbol) {
-    return !strncmp(source.data + token->start, symbol, token->end - token->start);
+    size_t length = token->end - token->start;
+    return strlen(symbol) == length && !strncmp(source.data + token->start, symbol, length);
 }
 
 char* token_string(TokenType type) {
@@ -302,13 +439,53 @@ char* token_string(TokenType type) {
         case TokenType_Comma: return "Comma"; break;
         case TokenType_Ampersand: return "Ampersand"; break;
         case TokenType_Arrow: return "Arrow"; break;
+        case TokenType_Star: return "Star"; break;
+        case TokenType_Slash: return "Slash"; break;
+        case TokenType_Tilde: return "Tilde"; break;
+        case TokenType_Bang: return "Bang"; break;
+        case TokenType_Percent: return "Percent"; break;
+        case TokenType_Pipe: return "Pipe"; break;
+        case TokenType_Caret: return "Caret"; break;
         case TokenType_Equals: return "Equals"; break;
         case TokenType_Plus: return "Plus"; break;
         case TokenType_Dash: return "Dash"; break;
+        case TokenType_EqualsEquals: return "EqualsEquals"; break;
+        case TokenType_BangEquals: return "BangEquals"; break;
+        case TokenType_Less: return "Less"; break;
+        case TokenType_LessEquals: return "LessEquals"; break;
+        case TokenType_Greater: return "Greater"; break;
+        case TokenType_GreaterEquals: return "GreaterEquals"; break;
+        case TokenType_ShiftLeft: return "ShiftLeft"; break;
+        case TokenType_ShiftRight: return "ShiftRight"; break;
+        case TokenType_LBracket: return "Left Bracket"; break;
+        case TokenType_RBracket: return "Right Bracket"; break;
+        case TokenType_Dot: return "Dot"; break;
+        case TokenType_DotDot: return "DotDot"; break;
         case TokenType_KeywordLet: return "Keyword(let)"; break;
+        case TokenType_KeywordMut: return "Keyword(mut)"; break;
         case TokenType_KeywordFn: return "Keyword(fn)"; break;
         case TokenType_KeywordReturn: return "Keyword(return)"; break;
         case TokenType_KeywordExtern: return "Keyword(extern)"; break;
+        case TokenType_KeywordIf: return "Keyword(if)"; break;
+        case TokenType_KeywordElse: return "Keyword(else)"; break;
+        case TokenType_KeywordTrue: return "Keyword(true)"; break;
+        case TokenType_KeywordFalse: return "Keyword(false)"; break;
+        case TokenType_KeywordFor: return "Keyword(for)"; break;
+        case TokenType_KeywordIn: return "Keyword(in)"; break;
+        case TokenType_KeywordWhile: return "Keyword(while)"; break;
+        case TokenType_KeywordLoop: return "Keyword(loop)"; break;
+        case TokenType_KeywordBreak: return "Keyword(break)"; break;
+        case TokenType_KeywordContinue: return "Keyword(continue)"; break;
+        case TokenType_KeywordVolatile: return "Keyword(volatile)"; break;
+        case TokenType_KeywordAsm: return "Keyword(asm)"; break;
+        case TokenType_KeywordTail: return "Keyword(tail)"; break;
+        case TokenType_KeywordStruct: return "Keyword(struct)"; break;
+        case TokenType_PlusPercent: return "Plus Percent"; break;
+        case TokenType_DashPercent: return "Dash Percent"; break;
+        case TokenType_StarPercent: return "Star Percent"; break;
+        case TokenType_PlusPipe: return "Plus Pipe"; break;
+        case TokenType_DashPipe: return "Dash Pipe"; break;
+        case TokenType_StarPipe: return "Star Pipe"; break;
         default: return "Unknown"; break;
     }
 }
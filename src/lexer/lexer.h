@@ -17,6 +17,9 @@ typedef enum TokenType {
 
     TokenType_LParen,
     TokenType_RParen,
+
+    TokenType_LBracket,
+    TokenType_RBracket,
     
     TokenType_Colon,
     TokenType_Semicolon,
@@ -27,12 +30,35 @@ typedef enum TokenType {
     TokenType_Slash,
     TokenType_Tilde,
     TokenType_Bang,
+    TokenType_Percent,
+    TokenType_Pipe,
+    TokenType_Caret,
 
     TokenType_Equals,
     TokenType_Plus,
     TokenType_Dash,
 
+    // wrapping +% -% *% and saturating +| -| *|
+    TokenType_PlusPercent,
+    TokenType_DashPercent,
+    TokenType_StarPercent,
+    TokenType_PlusPipe,
+    TokenType_DashPipe,
+    TokenType_StarPipe,
+
+    TokenType_EqualsEquals,
+    TokenType_BangEquals,
+    TokenType_Less,
+    TokenType_LessEquals,
+    TokenType_Greater,
+    TokenType_GreaterEquals,
+    TokenType_ShiftLeft,
+    TokenType_ShiftRight,
+    TokenType_Dot,
+    TokenType_DotDot,
+
     TokenType_KeywordLet,
+    TokenType_KeywordMut,
     TokenType_KeywordFn,
     TokenType_KeywordReturn,
     TokenType_KeywordExtern,
@@ -40,6 +66,16 @@ typedef enum TokenType {
     TokenType_KeywordElse,
     TokenType_KeywordTrue,
     TokenType_KeywordFalse,
+    TokenType_KeywordFor,
+    TokenType_KeywordIn,
+    TokenType_KeywordWhile,
+    TokenType_KeywordLoop,
+    TokenType_KeywordBreak,
+    TokenType_KeywordContinue,
+    TokenType_KeywordVolatile,
+    TokenType_KeywordAsm,
+    TokenType_KeywordTail,
+    TokenType_KeywordStruct,
 } TokenType;
 
 typedef struct TextPosition {
@@ -54,13 +54,71 @@ static Result read_file(const char* path, char** buffer, int* length) {
 }
 
 static void print_usage(char* command) {
-    fprintf(stderr, "\nUsage: %s <code>.sil\n\nOther Options:\n--version\t\tprints version\n--output <outfile>\tsets output file\n\n", command);
+    fprintf(
+        stderr,
+        "\nUsage: %s <code>.sil\n\n"
+        "Other Options:\n"
+        "--version\t\t\tprints version\n"
+        "--output <outfile>\t\tsets output object file\n"
+        "-O0 -O1 -O2 -O3 -Os -Oz\t\tsets optimization level\n"
+        "--target=<triple>\t\tsets target triple (default: host)\n"
+        "--cpu=<name>\t\t\tsets target cpu\n"
+        "--profile-generate[=<file>]\tinstruments functions to write a .profraw at exit\n"
+        "--profile-use=<file>\t\toptimizes using a merged .profdata\n"
+        "--instrument-functions\t\tcalls __sil_enter/__sil_exit(fn_id) around every function\n"
+        "--size-report[=<json file>]\tprints IR, code and string sizes per function\n"
+        "--stack-usage\t\t\tprints worst case stack depth from main and interrupts\n"
+        "--mca-report=<fn>[,<fn>]\truns the functions' assembly through llvm-mca for --cpu\n"
+        "--wcet\t\t\t\tprints worst case cycles per function for --cpu\n"
+        "--overflow=checked|fast\t\ttraps on integer overflow, or assumes there is none\n"
+        "\t\t\t\t(default: checked at -O0, fast otherwise)\n"
+        "--layout-report\t\t\tprints field offsets and padding of every struct\n"
+        "--release-fast\t\t\tdrops bounds checks, and overflow checks unless\n"
+        "\t\t\t\t--overflow=checked\n"
+        "--emit-ir=<file>\t\twrites the optimized IR as text\n"
+        "\n",
+        command
+    );
+}
+
+// matches "--name=value" and points value past the '='
+static int option_value(char* arg, const char* name, char** value) {
+    size_t name_length = strlen(name);
+    if (strncmp(arg, name, name_length) != 0 || arg[name_length] != '=') {
+        return 0;
+    }
+
+    *value = arg + name_length + 1;
+    return 1;
+}
+
+static int parse_optimization_level(char* arg, OptimizationLevel* level) {
+    if (strcmp(arg, "-O0") == 0) {
+        *level = OptimizationLevel_O0;
+    } else if (strcmp(arg, "-O1") == 0) {
+        *level = OptimizationLevel_O1;
+    } else if (strcmp(arg, "-O2") == 0) {
+        *level = OptimizationLevel_O2;
+    } else if (strcmp(arg, "-O3") == 0) {
+        *level = OptimizationLevel_O3;
+    } else if (strcmp(arg, "-Os") == 0) {
+        *level = OptimizationLevel_Os;
+    } else if (strcmp(arg, "-Oz") == 0) {
+        *level = OptimizationLevel_Oz;
+    } else {
+        return 0;
+    }
+
+    return 1;
 }
 
 int main(int argc, char** argv) {
     char* arg0 = argv[0];
     char* in_file_path = 0;
-    char* out_file_path = "output";
+    CodegenOptions options = {0};
+    options.output_path = "output";
+    char* overflow = NULL;
+    int release_fast = 0;
 
     for (int i = 1; i < argc; i++) {
         char* arg = argv[i];
@@ -71,11 +129,36 @@ int main(int argc, char** argv) {
                 return 0;
             } else if(strcmp(arg, "--output") == 0) {
                 i += 1;
-                out_file_path = argv[i];
+                options.output_path = argv[i];
+            } else if (option_value(arg, "--target", &options.target_triple)) {
+            } else if (option_value(arg, "--cpu", &options.cpu)) {
+            } else if (strcmp(arg, "--profile-generate") == 0) {
+                options.profile_generate = 1;
+            } else if (option_value(arg, "--profile-generate", &options.profile_generate_path)) {
+                options.profile_generate = 1;
+            } else if (option_value(arg, "--profile-use", &options.profile_use_path)) {
+            } else if (strcmp(arg, "--instrument-functions") == 0) {
+                options.instrument_functions = 1;
+            } else if (strcmp(arg, "--size-report") == 0) {
+                options.size_report = 1;
+            } else if (option_value(arg, "--size-report", &options.size_report_path)) {
+                options.size_report = 1;
+            } else if (strcmp(arg, "--stack-usage") == 0) {
+                options.stack_usage = 1;
+            } else if (option_value(arg, "--mca-report", &options.mca_functions)) {
+            } else if (strcmp(arg, "--wcet") == 0) {
+                options.wcet = 1;
+            } else if (option_value(arg, "--overflow", &overflow)) {
+            } else if (strcmp(arg, "--layout-report") == 0) {
+                options.layout_report = 1;
+            } else if (strcmp(arg, "--release-fast") == 0) {
+                release_fast = 1;
+            } else if (option_value(arg, "--emit-ir", &options.ir_path)) {
             } else {
                 print_usage(arg0);
                 return EXIT_FAILURE;
             }
+        } else if (parse_optimization_level(arg, &options.optimization_level)) {
         } else if (in_file_path == 0) {
             in_file_path = arg;
         } else {
@@ -84,11 +167,31 @@ int main(int argc, char** argv) {
         }
     }
 
-    if (in_file_path == 0 || out_file_path == 0) {
+    if (in_file_path == 0 || options.output_path == 0) {
         print_usage(arg0);
         return EXIT_FAILURE;
     }
 
+    // debug builds check arithmetic, optimized builds may assume it fits
+    if (overflow == NULL) {
+        options.overflow_checks = !release_fast && options.optimization_level == OptimizationLevel_O0;
+    } else if (strcmp(overflow, "checked") == 0) {
+        options.overflow_checks = 1;
+    } else if (strcmp(overflow, "fast") == 0) {
+        options.overflow_checks = 0;
+    } else {
+        print_usage(arg0);
+        return EXIT_FAILURE;
+    }
+
+    // indices are checked at every level; loop ranges remove most checks
+    options.bounds_checks = !release_fast;
+
+    if (options.profile_generate && options.profile_use_path != NULL) {
+        fprintf(stderr, "--profile-generate and --profile-use are exclusive\n");
+        return EXIT_FAILURE;
+    }
+
     char* buffer;
     int length;
     Result read_file_result = read_file(in_file_path, &buffer, &length);
@@ -120,7 +223,7 @@ int main(int argc, char** argv) {
     parser_print_ast(ast_root);
 
     printf("\nGenerating Code...\n");
-    codegen_generate(ast_root);
+    codegen_generate(ast_root, &options);
     list_delete(&token_list);
 
     return EXIT_SUCCESS;
@@ -2,14 +2,35 @@
 
 #include "lexer/lexer.h"
 #include "parser.h"
+#include "util.h"
+
+#include <stdlib.h>
 
 static void operator_precedence(Token* operator, int* left, int* right) {
     OperatorPrecedence precedence;
     switch (operator->type) {
-        case TokenType_Plus: precedence = OperatorPrecedence_Addition; break;
-        case TokenType_Dash: precedence = OperatorPrecedence_Subtration; break;
-        case TokenType_Star: precedence = OperatorPrecedence_Multiplication; break;
+        case TokenType_Plus:
+        case TokenType_PlusPercent:
+        case TokenType_PlusPipe: precedence = OperatorPrecedence_Addition; break;
+        case TokenType_Dash:
+        case TokenType_DashPercent:
+        case TokenType_DashPipe: precedence = OperatorPrecedence_Subtration; break;
+        case TokenType_Star:
+        case TokenType_StarPercent:
+        case TokenType_StarPipe: precedence = OperatorPrecedence_Multiplication; break;
         case TokenType_Slash: precedence = OperatorPrecedence_Divisioon; break;
+        case TokenType_Percent: precedence = OperatorPrecedence_Remainder; break;
+        case TokenType_ShiftLeft:
+        case TokenType_ShiftRight: precedence = OperatorPrecedence_Shift; break;
+        case TokenType_Ampersand: precedence = OperatorPrecedence_BitwiseAnd; break;
+        case TokenType_Caret: precedence = OperatorPrecedence_BitwiseXor; break;
+        case TokenType_Pipe: precedence = OperatorPrecedence_BitwiseOr; break;
+        case TokenType_EqualsEquals:
+        case TokenType_BangEquals:
+        case TokenType_Less:
+        case TokenType_LessEquals:
+        case TokenType_Greater:
+        case TokenType_GreaterEquals: precedence = OperatorPrecedence_Comparison; break;
         default: precedence = OperatorPrecedence_Invalid;
     }
 
@@ -17,7 +38,223 @@ static void operator_precedence(Token* operator, int* left, int* right) {
     *right = precedence * 2;
 }
 
+// Contents of a string literal token without its quotes, escapes decoded.
+static String string_literal_text(ParserContext* context, Token* token) {
+    char* source = context->source.data + token->start + 1;
+    size_t length = token->end - token->start - 2;
+
+    char* text = malloc(length + 1);
+    size_t text_length = 0;
+    for (size_t i = 0; i < length; i++) {
+        char c = source[i];
+        if (c == '\\' && i + 1 < length) {
+            i++;
+            switch (source[i]) {
+                case 'n': c = '\n'; break;
+                case 't': c = '\t'; break;
+                case '0': c = '\0'; break;
+                default: c = source[i]; break;
+            }
+        }
+        text[text_length++] = c;
+    }
+    text[text_length] = 0;
+
+    return (String){ text, text_length };
+}
+
+static String expect_string_literal(ParserContext* context) {
+    return string_literal_text(context, expect_token(context, TokenType_StringLiteral));
+}
+
+// asm: asm mnemonic operands ; | asm [volatile] ( "template" [: output [: inputs [: clobbers]]] )
+AstNode* parse_asm(ParserContext* context) {
+    AstNode* node = node_new(AstNodeType_Asm);
+    AstNodeAsm* asm_expression = &node->data.asm_expression;
+
+    expect_token(context, TokenType_KeywordAsm);
+
+    // asm nop; takes the instruction text as written, like basic asm in C
+    Token* first = current_token(context);
+    if (first->type == TokenType_Symbol) {
+        unsigned int end = first->start;
+        while (current_token(context)->type != TokenType_Semicolon) {
+            if (current_token(context)->type == TokenType_Eof) {
+                sil_panic("Expected ; after asm (%d:%d)", first->position.line, first->position.column);
+            }
+            end = current_token(context)->end;
+            consume_token(context);
+        }
+
+        asm_expression->template = string_from_buffer(context->source.data + first->start, end - first->start);
+        asm_expression->is_volatile = 1;
+        return node;
+    }
+
+    if (current_token(context)->type == TokenType_KeywordVolatile) {
+        consume_token(context);
+        asm_expression->is_volatile = 1;
+    }
+
+    expect_token(context, TokenType_LParen);
+    asm_expression->template = expect_string_literal(context);
+
+    // output section: "=r" -> type
+    if (current_token(context)->type == TokenType_Colon) {
+        consume_token(context);
+        if (current_token(context)->type == TokenType_StringLiteral) {
+            Token* token = current_token(context);
+            asm_expression->output_constraint = expect_string_literal(context);
+            if (asm_expression->output_constraint.data[0] != '=') {
+                sil_panic("asm output constraint must start with = (%d:%d)", token->position.line, token->position.column);
+            }
+            expect_token(context, TokenType_Arrow);
+            asm_expression->output_type = parse_type_name(context);
+        }
+    }
+
+    // input section: "r"(value), ...
+    if (current_token(context)->type == TokenType_Colon) {
+        consume_token(context);
+        while (current_token(context)->type == TokenType_StringLiteral) {
+            AsmOperand* input = list_add(AsmOperand, &asm_expression->inputs);
+            input->constraint = expect_string_literal(context);
+            expect_token(context, TokenType_LParen);
+            input->value = parse_expression(context);
+            expect_token(context, TokenType_RParen);
+
+            if (current_token(context)->type != TokenType_Comma) {
+                break;
+            }
+            consume_token(context);
+        }
+    }
+
+    // clobber section: "memory", "cc", ...
+    if (current_token(context)->type == TokenType_Colon) {
+        consume_token(context);
+        while (current_token(context)->type == TokenType_StringLiteral) {
+            String clobber = expect_string_literal(context);
+            list_push(String, &asm_expression->clobbers, &clobber);
+
+            if (current_token(context)->type != TokenType_Comma) {
+                break;
+            }
+            consume_token(context);
+        }
+    }
+
+    expect_token(context, TokenType_RParen);
+
+    return node;
+}
+
+// postfix: [.field | [index]]*
+static AstNode* parse_postfix(ParserContext* context, AstNode* value) {
+    while (current_token(context)->type == TokenType_Dot || current_token(context)->type == TokenType_LBracket) {
+        if (current_token(context)->type == TokenType_LBracket) {
+            consume_token(context);
+
+            AstNode* index = node_new(AstNodeType_Index);
+            index->data.index.value = value;
+            index->data.index.index = parse_expression(context);
+            if (current_token(context)->type == TokenType_DotDot) {
+                consume_token(context);
+                index->data.index.end = parse_expression(context);
+            }
+            value = index;
+
+            expect_token(context, TokenType_RBracket);
+            continue;
+        }
+
+        consume_token(context);
+        Token* field_token = expect_token(context, TokenType_Symbol);
+
+        AstNode* field_access = node_new(AstNodeType_FieldAccess);
+        field_access->data.field_access.value = value;
+        field_access->data.field_access.field = string_from_token(context->source.data, field_token);
+        value = field_access;
+    }
+
+    return value;
+}
+
+// Name { is a struct literal only when a field follows, since the brace
+// after if x or while x opens a block.
+static int is_struct_literal(ParserContext* context) {
+    Token* brace = current_token(context);
+    Token* field = list_get(Token, context->token_list, context->token_index + 1);
+    if (brace->type != TokenType_LBrace || field->type != TokenType_Symbol) {
+        return 0;
+    }
+
+    Token* colon = list_get(Token, context->token_list, context->token_index + 2);
+    return colon->type == TokenType_Colon;
+}
+
+// structLiteral: Name { [field: expression],* }
+static AstNode* parse_struct_literal(ParserContext* context, Token* name_token) {
+    AstNode* literal = node_new(AstNodeType_StructLiteral);
+    literal->data.struct_literal.name = string_from_token(context->source.data, name_token);
+
+    expect_token(context, TokenType_LBrace);
+
+    while (current_token(context)->type != TokenType_RBrace) {
+        Token* field_token = expect_token(context, TokenType_Symbol);
+        expect_token(context, TokenType_Colon);
+
+        StructLiteralField* field = list_add(StructLiteralField, &literal->data.struct_literal.fields);
+        field->name = string_from_token(context->source.data, field_token);
+        field->value = parse_expression(context);
+
+        if (current_token(context)->type != TokenType_Comma) {
+            break;
+        }
+        consume_token(context);
+    }
+
+    expect_token(context, TokenType_RBrace);
+
+    return literal;
+}
+
+// arrayLiteral: [ [expression],* ] | [ expression ; count ]
+static AstNode* parse_array_literal(ParserContext* context) {
+    AstNode* literal = node_new(AstNodeType_ArrayLiteral);
+    AstNodeArrayLiteral* array = &literal->data.array_literal;
+
+    while (current_token(context)->type != TokenType_RBracket) {
+        AstNode* element = parse_expression(context);
+        list_push(AstNode*, &array->elements, &element);
+
+        if (array->elements.length == 1 && current_token(context)->type == TokenType_Semicolon) {
+            consume_token(context);
+            array->is_repeat = 1;
+            array->count = expect_count(context, "Repeat count");
+            break;
+        }
+
+        if (current_token(context)->type != TokenType_Comma) {
+            break;
+        }
+        consume_token(context);
+    }
+
+    Token* end = expect_token(context, TokenType_RBracket);
+
+    if (array->elements.length == 0 || (array->is_repeat && array->count == 0)) {
+        sil_panic("Array literal needs at least one element (%d:%d)", end->position.line, end->position.column);
+    }
+
+    return literal;
+}
+
 static AstNode* parse_expression_primary(ParserContext* context) {
+    if (current_token(context)->type == TokenType_KeywordAsm) {
+        return parse_asm(context);
+    }
+
     Token* token = current_token(context);
     consume_token(context);
 
@@ -64,6 +301,20 @@ static AstNode* parse_expression_primary(ParserContext* context) {
         }
 
         case TokenType_Symbol: {
+            if (is_struct_literal(context)) {
+                return parse_postfix(context, parse_struct_literal(context, token));
+            }
+
+            if (current_token(context)->type != TokenType_LParen) {
+                AstNode* variable = node_new(AstNodeType_PrimaryExpression);
+                variable->data.primary_expression.type = PrimaryExpressionType_Variable;
+                String name = string_from_token(context->source.data, token);
+                variable->data.primary_expression.variable.name = name;
+                variable->data.primary_expression.variable.symbol = intern_symbol(context, name);
+
+                return parse_postfix(context, variable);
+            }
+
             AstNode* fn_call = node_new(AstNodeType_PrimaryExpression);
             fn_call->data.primary_expression.type = PrimaryExpressionType_Symbol;
             fn_call->data.primary_expression.function_call.name = string_from_token(
@@ -72,27 +323,42 @@ static AstNode* parse_expression_primary(ParserContext* context) {
 
             expect_token(context, TokenType_LParen);
 
-            if (current_token(context)->type != TokenType_RParen) {
+            while (current_token(context)->type != TokenType_RParen) {
                 AstNode* parameter = parse_expression(context);
                 list_push(
                     AstNode*,
                     &fn_call->data.primary_expression.function_call.parameters,
                     &parameter
                 );
+
+                if (current_token(context)->type != TokenType_Comma) {
+                    break;
+                }
+                consume_token(context);
             }
 
             expect_token(context, TokenType_RParen);
 
-            return fn_call;
+            return parse_postfix(context, fn_call);
+        }
+
+        case TokenType_LBracket:
+            return parse_postfix(context, parse_array_literal(context));
+
+        case TokenType_KeywordTrue:
+        case TokenType_KeywordFalse: {
+            AstNode* bool_literal = node_new(AstNodeType_PrimaryExpression);
+            bool_literal->data.primary_expression.type = PrimaryExpressionType_Bool;
+            bool_literal->data.primary_expression.boolean = token->type == TokenType_KeywordTrue;
+
+            return bool_literal;
         }
 
         case TokenType_StringLiteral: {
             AstNode* string_literal = node_new(AstNodeType_PrimaryExpression);
 
             string_literal->data.primary_expression.type = PrimaryExpressionType_String;
-            string_literal->data.primary_expression.string = string_from_token(
-                context->source.data, token
-            );
+            string_literal->data.primary_expression.string = string_literal_text(context, token);
             return string_literal;
         }
         case TokenType_NumberLiteral: {
@@ -117,6 +383,7 @@ static AstNode* parse_expression_prec(ParserContext* context, int precedence) {
         consume_token(context);
         left_expression = parse_expression(context);
         expect_token(context, TokenType_RParen);
+        left_expression = parse_postfix(context, left_expression);
     } else {
         left_expression = parse_expression_primary(context);
     }
@@ -124,7 +391,7 @@ static AstNode* parse_expression_prec(ParserContext* context, int precedence) {
     int left;
     int right;
     while (1) {
-        // check if there is an infix operator (+, -, *, /)
+        // check if there is an infix operator
         Token* operator_token = current_token(context);
         operator_precedence(operator_token, &left, &right);
         if (left == -1) {
@@ -149,9 +416,63 @@ static AstNode* parse_expression_prec(ParserContext* context, int precedence) {
             case TokenType_Star:
                 operator->data.binary_operator.type = BinaryOperatorType_Multiplication;
                 break;
+            case TokenType_PlusPercent:
+                operator->data.binary_operator.type = BinaryOperatorType_WrappingAddition;
+                break;
+            case TokenType_DashPercent:
+                operator->data.binary_operator.type = BinaryOperatorType_WrappingSubtraction;
+                break;
+            case TokenType_StarPercent:
+                operator->data.binary_operator.type = BinaryOperatorType_WrappingMultiplication;
+                break;
+            case TokenType_PlusPipe:
+                operator->data.binary_operator.type = BinaryOperatorType_SaturatingAddition;
+                break;
+            case TokenType_DashPipe:
+                operator->data.binary_operator.type = BinaryOperatorType_SaturatingSubtraction;
+                break;
+            case TokenType_StarPipe:
+                operator->data.binary_operator.type = BinaryOperatorType_SaturatingMultiplication;
+                break;
             case TokenType_Slash:
                 operator->data.binary_operator.type = BinaryOperatorType_Division;
                 break;
+            case TokenType_Percent:
+                operator->data.binary_operator.type = BinaryOperatorType_Remainder;
+                break;
+            case TokenType_ShiftLeft:
+                operator->data.binary_operator.type = BinaryOperatorType_ShiftLeft;
+                break;
+            case TokenType_ShiftRight:
+                operator->data.binary_operator.type = BinaryOperatorType_ShiftRight;
+                break;
+            case TokenType_Ampersand:
+                operator->data.binary_operator.type = BinaryOperatorType_BitwiseAnd;
+                break;
+            case TokenType_Pipe:
+                operator->data.binary_operator.type = BinaryOperatorType_BitwiseOr;
+                break;
+            case TokenType_Caret:
+                operator->data.binary_operator.type = BinaryOperatorType_BitwiseXor;
+                break;
+            case TokenType_EqualsEquals:
+                operator->data.binary_operator.type = BinaryOperatorType_Equal;
+                break;
+            case TokenType_BangEquals:
+                operator->data.binary_operator.type = BinaryOperatorType_NotEqual;
+                break;
+            case TokenType_Less:
+                operator->data.binary_operator.type = BinaryOperatorType_Less;
+                break;
+            case TokenType_LessEquals:
+                operator->data.binary_operator.type = BinaryOperatorType_LessEqual;
+                break;
+            case TokenType_Greater:
+                operator->data.binary_operator.type = BinaryOperatorType_Greater;
+                break;
+            case TokenType_GreaterEquals:
+                operator->data.binary_operator.type = BinaryOperatorType_GreaterEqual;
+                break;
             default:
                 sil_panic("Parser Error: Unhandled operator");
         }
@@ -11,6 +11,8 @@ typedef enum PrimaryExpressionType {
     PrimaryExpressionType_Number,
     PrimaryExpressionType_String,
     PrimaryExpressionType_Symbol,
+    PrimaryExpressionType_Variable,
+    PrimaryExpressionType_Bool,
 } PrimaryExpressionType;
 
 typedef struct PrimaryExpressionFunctionCall {
@@ -18,11 +20,18 @@ typedef struct PrimaryExpressionFunctionCall {
     List parameters;
 } PrimaryExpressionFunctionCall;
 
+typedef struct PrimaryExpressionVariable {
+    String name;
+    unsigned int symbol;
+} PrimaryExpressionVariable;
+
 typedef struct AstNodePrimaryExpression {
     PrimaryExpressionType type;
     union {
         String number;
         String string;
+        PrimaryExpressionVariable variable;
+        int boolean;
         PrimaryExpressionFunctionCall function_call;
     };
 } AstNodePrimaryExpression;
@@ -33,12 +42,67 @@ typedef struct AstNodeIfExpression {
     AstNode* alt;
 } AstNodeIfExpression;
 
+typedef struct StructLiteralField {
+    String name;
+    AstNode* value;
+} StructLiteralField;
+
+// Name { field: value, ... }
+typedef struct AstNodeStructLiteral {
+    String name;
+    List fields;
+} AstNodeStructLiteral;
+
+// value.field
+typedef struct AstNodeFieldAccess {
+    AstNode* value;
+    String field;
+} AstNodeFieldAccess;
+
+// [a, b, c], or [value; count] with its one element repeated
+typedef struct AstNodeArrayLiteral {
+    List elements;
+    int is_repeat;
+    unsigned int count;
+} AstNodeArrayLiteral;
+
+// value[index], or value[index..end] for a slice
+typedef struct AstNodeIndex {
+    AstNode* value;
+    AstNode* index;
+    AstNode* end;
+} AstNodeIndex;
+
+// "r"(value), an input bound to a constraint
+typedef struct AsmOperand {
+    String constraint;
+    AstNode* value;
+} AsmOperand;
+
+// asm [volatile] ("template" : "=r" -> type : "r"(x), ... : "memory", ...)
+// Operands are $0, $1, ... in the template, the output first.
+typedef struct AstNodeAsm {
+    String template;
+    int is_volatile;
+    // empty when the asm produces no value
+    String output_constraint;
+    AstNode* output_type;
+    List inputs;
+    List clobbers;
+} AstNodeAsm;
+
 typedef enum OperatorPrecedence {
     OperatorPrecedence_Invalid,
-    OperatorPrecedence_Addition = 1,
-    OperatorPrecedence_Subtration = 1,
-    OperatorPrecedence_Multiplication = 2,
-    OperatorPrecedence_Divisioon = 2,
+    OperatorPrecedence_Comparison = 1,
+    OperatorPrecedence_BitwiseOr = 2,
+    OperatorPrecedence_BitwiseXor = 3,
+    OperatorPrecedence_BitwiseAnd = 4,
+    OperatorPrecedence_Shift = 5,
+    OperatorPrecedence_Addition = 6,
+    OperatorPrecedence_Subtration = 6,
+    OperatorPrecedence_Multiplication = 7,
+    OperatorPrecedence_Divisioon = 7,
+    OperatorPrecedence_Remainder = 7,
 } OperatorPrecedence;
 
 typedef enum UnaryOperatorType {
@@ -57,6 +121,26 @@ typedef enum  BinaryOperatorType {
     BinaryOperatorType_Subtraction,
     BinaryOperatorType_Multiplication,
     BinaryOperatorType_Division,
+    BinaryOperatorType_Remainder,
+    BinaryOperatorType_ShiftLeft,
+    BinaryOperatorType_ShiftRight,
+    BinaryOperatorType_BitwiseAnd,
+    BinaryOperatorType_BitwiseOr,
+    BinaryOperatorType_BitwiseXor,
+    // overflow wraps around or clamps instead of being illegal
+    BinaryOperatorType_WrappingAddition,
+    BinaryOperatorType_WrappingSubtraction,
+    BinaryOperatorType_WrappingMultiplication,
+    BinaryOperatorType_SaturatingAddition,
+    BinaryOperatorType_SaturatingSubtraction,
+    BinaryOperatorType_SaturatingMultiplication,
+    // comparisons come last
+    BinaryOperatorType_Equal,
+    BinaryOperatorType_NotEqual,
+    BinaryOperatorType_Less,
+    BinaryOperatorType_LessEqual,
+    BinaryOperatorType_Greater,
+    BinaryOperatorType_GreaterEqual,
 } BinaryOperatorType;
 
 typedef struct AstNodeBinaryOperator {
@@ -66,5 +150,6 @@ typedef struct AstNodeBinaryOperator {
 } AstNodeInfixOperator;
 
 AstNode* parse_expression(ParserContext* context);
+AstNode* parse_asm(ParserContext* context);
 
 #endif
@@ -5,6 +5,8 @@
 #include "list.h"
 #include "string_buffer.h"
 #include "util.h"
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -34,6 +36,28 @@ Token* expect_token(ParserContext* context, TokenType type) {
     return token;
 }
 
+// A count written as an integer literal, like an array length: from 1 up
+// to what an unsigned int holds.
+unsigned int expect_count(ParserContext* context, const char* what) {
+    Token* token = expect_token(context, TokenType_NumberLiteral);
+    String text = { context->source.data + token->start, token->end - token->start };
+
+    unsigned long long count;
+    if (!string_to_integer(text, &count) || count == 0 || count > UINT_MAX) {
+        sil_panic(
+            "%s must be an integer from 1 to %u, got %.*s (%d:%d)",
+            what,
+            UINT_MAX,
+            text.length,
+            text.data,
+            token->position.line,
+            token->position.column
+        );
+    }
+
+    return count;
+}
+
 AstNode* node_new(AstNodeType type) {
     AstNode* node = calloc(1, sizeof(AstNode));
     node->type = type;
@@ -41,7 +65,21 @@ AstNode* node_new(AstNodeType type) {
     return node;
 }
 
-static AstNode* parse_type_name(ParserContext* context) {
+unsigned int intern_symbol(ParserContext* context, String name) {
+    // ids are stored off by one so a missing entry reads as NULL
+    void* entry = map_get(&context->symbols, name);
+    if (entry != NULL) {
+        return (unsigned int)(uintptr_t)entry - 1;
+    }
+
+    unsigned int symbol = context->symbol_count;
+    context->symbol_count += 1;
+    map_insert(&context->symbols, name, (void*)(uintptr_t)(symbol + 1));
+
+    return symbol;
+}
+
+AstNode* parse_type_name(ParserContext* context) {
     AstNode* type_name = node_new(AstNodeType_TypeName);
 
     if (current_token(context)->type == TokenType_Star) {
@@ -52,20 +90,126 @@ static AstNode* parse_type_name(ParserContext* context) {
         return type_name;
     }
 
+    // [length]element, []element or []const element
+    if (current_token(context)->type == TokenType_LBracket) {
+        consume_token(context);
+        if (current_token(context)->type == TokenType_RBracket) {
+            consume_token(context);
+            type_name->data.type_name.type = AstNodeTypeNameType_Slice;
+            if (token_symbol_compare(context->source, current_token(context), "const")) {
+                consume_token(context);
+                type_name->data.type_name.is_const = 1;
+            }
+            type_name->data.type_name.child_type = parse_type_name(context);
+
+            return type_name;
+        }
+
+        type_name->data.type_name.length = expect_count(context, "Array length");
+        expect_token(context, TokenType_RBracket);
+        type_name->data.type_name.type = AstNodeTypeNameType_Array;
+        type_name->data.type_name.child_type = parse_type_name(context);
+
+        return type_name;
+    }
+
+    // @soa [length]struct
+    if (token_symbol_compare(context->source, current_token(context), "@soa")) {
+        Token* soa_token = current_token(context);
+        consume_token(context);
+        if (current_token(context)->type != TokenType_LBracket) {
+            sil_panic("@soa applies to an array type (%d:%d)", soa_token->position.line, soa_token->position.column);
+        }
+
+        type_name = parse_type_name(context);
+        if (type_name->data.type_name.type != AstNodeTypeNameType_Array) {
+            sil_panic("@soa applies to an array type (%d:%d)", soa_token->position.line, soa_token->position.column);
+        }
+        type_name->data.type_name.is_soa = 1;
+
+        return type_name;
+    }
+
+    // @Vector(lanes, element)
+    if (token_symbol_compare(context->source, current_token(context), "@Vector")) {
+        consume_token(context);
+        expect_token(context, TokenType_LParen);
+        type_name->data.type_name.lanes = expect_count(context, "Vector lane count");
+        expect_token(context, TokenType_Comma);
+        type_name->data.type_name.type = AstNodeTypeNameType_Vector;
+        type_name->data.type_name.child_type = parse_type_name(context);
+        expect_token(context, TokenType_RParen);
+
+        return type_name;
+    }
+
     type_name->data.type_name.type = AstNodeTypeNameType_Primitive;
+
+    // ! is the never type, spelled unreachable as well
+    if (current_token(context)->type == TokenType_Bang) {
+        consume_token(context);
+        type_name->data.type_name.primitive = AstTypeName_unreachable;
+        return type_name;
+    }
+
     Token* token = expect_token(context, TokenType_Symbol);
     
+    static struct {
+        char* name;
+        AstTypeName primitive;
+    } primitives[] = {
+        { "void", AstTypeName_void },
+        { "bool", AstTypeName_bool },
+        { "isize", AstTypeName_isize },
+        { "usize", AstTypeName_usize },
+        { "f32", AstTypeName_f32 },
+        { "f64", AstTypeName_f64 },
+        { "unreachable", AstTypeName_unreachable },
+    };
+
+    int found = 0;
     AstTypeName primitive;
-    if (token_symbol_compare(context->source, token, "i8")) {
-        primitive = AstTypeName_i8;
-    } else if (token_symbol_compare(context->source, token, "u8")) {
-        primitive = AstTypeName_u8;
-    } else if (token_symbol_compare(context->source, token, "i32")) {
-        primitive = AstTypeName_i32;
-    } else if (token_symbol_compare(context->source, token, "unreachable")) {
-        primitive = AstTypeName_unreachable;
-    } else {
-        sil_panic("Unknown primitive type");
+
+    // iN and uN for any width from 1 to 64
+    char* text = context->source.data + token->start;
+    size_t length = token->end - token->start;
+    int is_int = (text[0] == 'i' || text[0] == 'u') && length > 1 && length <= 3;
+    unsigned int bits = 0;
+    for (int i = 1; is_int && i < length; i++) {
+        is_int = text[i] >= '0' && text[i] <= '9';
+        bits = bits * 10 + (text[i] - '0');
+    }
+
+    if (is_int) {
+        if (bits == 0 || bits > 64 || text[1] == '0') {
+            sil_panic(
+                "Integer width must be 1 to 64: %.*s (%d:%d)",
+                (int)length,
+                text,
+                token->position.line,
+                token->position.column
+            );
+        }
+
+        primitive = AstTypeName_int;
+        type_name->data.type_name.bits = bits;
+        type_name->data.type_name.is_signed = text[0] == 'i';
+        found = 1;
+    }
+
+    for (int i = 0; !found && i < sizeof(primitives) / sizeof(primitives[0]); i++) {
+        if (token_symbol_compare(context->source, token, primitives[i].name)) {
+            primitive = primitives[i].primitive;
+            found = 1;
+            break;
+        }
+    }
+
+    // anything else names a struct, which may be declared further down
+    if (!found) {
+        type_name->data.type_name.type = AstNodeTypeNameType_Named;
+        type_name->data.type_name.name = string_from_token(context->source.data, token);
+        return type_name;
     }
 
     type_name->data.type_name.primitive = primitive;
@@ -82,6 +226,7 @@ static AstNode* parse_pattern(ParserContext* context) {
         context->source.data + name_token->start,
         name_token->end - name_token->start
     );
+    pattern->data.pattern.symbol = intern_symbol(context, pattern->data.pattern.name);
 
     expect_token(context, TokenType_Colon);
 
@@ -90,16 +235,211 @@ static AstNode* parse_pattern(ParserContext* context) {
     return pattern;
 }
 
-// statement: [returnStatement | ifStatement | ExpressionStatment] ;
+// let: let [mut] name [: type] = expression ;
+static AstNode* parse_let(ParserContext* context) {
+    AstNode* statement = node_new(AstNodeType_StatementLet);
+
+    expect_token(context, TokenType_KeywordLet);
+
+    if (current_token(context)->type == TokenType_KeywordMut) {
+        consume_token(context);
+        statement->data.statement_let.is_mutable = 1;
+    }
+
+    Token* name_token = expect_token(context, TokenType_Symbol);
+    statement->data.statement_let.name = string_from_token(context->source.data, name_token);
+    statement->data.statement_let.symbol = intern_symbol(context, statement->data.statement_let.name);
+
+    if (current_token(context)->type == TokenType_Colon) {
+        consume_token(context);
+        statement->data.statement_let.type = parse_type_name(context);
+    }
+
+    expect_token(context, TokenType_Equals);
+
+    statement->data.statement_let.value = parse_expression(context);
+
+    expect_token(context, TokenType_Semicolon);
+
+    return statement;
+}
+
+static int parse_hint_argument(ParserContext* context) {
+    expect_token(context, TokenType_LParen);
+    Token* token = expect_token(context, TokenType_NumberLiteral);
+    expect_token(context, TokenType_RParen);
+
+    int value = atoi(context->source.data + token->start);
+    if (value <= 0) {
+        sil_panic("Loop hint needs a positive count (%d:%d)", token->position.line, token->position.column);
+    }
+
+    return value;
+}
+
+// hints: [volatile | #unroll[(n)] | #vectorize(width) | #no_vectorize]*
+static AstLoopHints parse_loop_hints(ParserContext* context) {
+    AstLoopHints hints = {0};
+
+    while (1) {
+        Token* token = current_token(context);
+        if (token->type == TokenType_KeywordVolatile) {
+            consume_token(context);
+            hints.is_volatile = 1;
+        } else if (token->type == TokenType_Symbol && token_symbol_compare(context->source, token, "#unroll")) {
+            consume_token(context);
+            hints.unroll = current_token(context)->type == TokenType_LParen ? parse_hint_argument(context) : -1;
+        } else if (token->type == TokenType_Symbol && token_symbol_compare(context->source, token, "#vectorize")) {
+            consume_token(context);
+            hints.vectorize_width = parse_hint_argument(context);
+        } else if (token->type == TokenType_Symbol && token_symbol_compare(context->source, token, "#no_vectorize")) {
+            consume_token(context);
+            hints.vectorize_width = 1;
+        } else if (token->type == TokenType_Symbol && context->source.data[token->start] == '#') {
+            sil_panic(
+                "Unknown loop hint %.*s (%d:%d)",
+                token->end - token->start,
+                context->source.data + token->start,
+                token->position.line,
+                token->position.column
+            );
+        } else {
+            return hints;
+        }
+    }
+}
+
+// for: for name in [start..end] hints block
+static AstNode* parse_for(ParserContext* context) {
+    AstNode* statement = node_new(AstNodeType_StatementFor);
+
+    expect_token(context, TokenType_KeywordFor);
+
+    Token* name_token = expect_token(context, TokenType_Symbol);
+    statement->data.statement_for.name = string_from_token(context->source.data, name_token);
+    statement->data.statement_for.symbol = intern_symbol(context, statement->data.statement_for.name);
+
+    expect_token(context, TokenType_KeywordIn);
+    expect_token(context, TokenType_LBracket);
+    statement->data.statement_for.start = parse_expression(context);
+    expect_token(context, TokenType_DotDot);
+    statement->data.statement_for.end = parse_expression(context);
+    expect_token(context, TokenType_RBracket);
+
+    statement->data.statement_for.hints = parse_loop_hints(context);
+    statement->data.statement_for.body = parse_block(context);
+
+    return statement;
+}
+
+// while: [while expression | loop] hints block
+static AstNode* parse_while(ParserContext* context) {
+    AstNode* statement = node_new(AstNodeType_StatementWhile);
+
+    if (current_token(context)->type == TokenType_KeywordWhile) {
+        consume_token(context);
+        statement->data.statement_while.condition = parse_expression(context);
+    } else {
+        expect_token(context, TokenType_KeywordLoop);
+    }
+
+    statement->data.statement_while.hints = parse_loop_hints(context);
+    statement->data.statement_while.body = parse_block(context);
+
+    return statement;
+}
+
+static AstNode* parse_expression_statement(ParserContext* context, AstNode* expression) {
+    // the block's value, handed back unwrapped
+    if (current_token(context)->type == TokenType_RBrace) {
+        return expression;
+    }
+
+    AstNode* statement = node_new(AstNodeType_StatementExpression);
+
+    statement->data.statement_expression.expression = expression;
+
+    expect_token(context, TokenType_Semicolon);
+
+    return statement;
+}
+
+// statement: [returnStatement | letStatement | assignment | ifStatement | loop | ExpressionStatment] ;
 static AstNode* parse_statement(ParserContext* context) {
     Token* token = current_token(context);
 
     switch (token->type) {
+        case TokenType_KeywordLet:
+            return parse_let(context);
+
+        case TokenType_KeywordFor:
+            return parse_for(context);
+
+        case TokenType_KeywordWhile:
+        case TokenType_KeywordLoop:
+            return parse_while(context);
+
+        case TokenType_KeywordBreak:
+        case TokenType_KeywordContinue: {
+            AstNodeType type = token->type == TokenType_KeywordBreak
+                ? AstNodeType_StatementBreak
+                : AstNodeType_StatementContinue;
+            AstNode* statement = node_new(type);
+
+            consume_token(context);
+            expect_token(context, TokenType_Semicolon);
+
+            return statement;
+        }
+
+        case TokenType_Symbol: {
+            Token* next_token = list_get(Token, context->token_list, context->token_index + 1);
+
+            // p.x = value, a[i] = value
+            if (next_token->type == TokenType_Dot || next_token->type == TokenType_LBracket) {
+                AstNode* target = parse_expression(context);
+                if (current_token(context)->type != TokenType_Equals) {
+                    return parse_expression_statement(context, target);
+                }
+                consume_token(context);
+
+                AstNode* statement = node_new(AstNodeType_StatementAssign);
+                statement->data.statement_assign.target = target;
+                statement->data.statement_assign.value = parse_expression(context);
+
+                expect_token(context, TokenType_Semicolon);
+
+                return statement;
+            }
+
+            if (next_token->type != TokenType_Equals) {
+                break;
+            }
+
+            AstNode* statement = node_new(AstNodeType_StatementAssign);
+
+            consume_token(context);
+            consume_token(context);
+
+            statement->data.statement_assign.name = string_from_token(context->source.data, token);
+            statement->data.statement_assign.symbol = intern_symbol(context, statement->data.statement_assign.name);
+            statement->data.statement_assign.value = parse_expression(context);
+
+            expect_token(context, TokenType_Semicolon);
+
+            return statement;
+        }
+
         case TokenType_KeywordReturn: {
             AstNode* statement = node_new(AstNodeType_StatementReturn);
 
             consume_token(context);
 
+            if (current_token(context)->type == TokenType_KeywordTail) {
+                consume_token(context);
+                statement->data.statement_return.is_tail = 1;
+            }
+
             AstNode* expression = parse_expression(context);
 
             statement->data.statement_return.expression = expression;
@@ -113,18 +453,28 @@ static AstNode* parse_statement(ParserContext* context) {
             return parse_expression(context);
         }
         
-        default: {
-            AstNode* statement = node_new(AstNodeType_StatementExpression);
-
-            AstNode* expression = parse_expression(context);
-
-            statement->data.statement_expression.expression = expression;
+        default:
+            break;
+    } 
 
-            expect_token(context, TokenType_Semicolon);
+    return parse_expression_statement(context, parse_expression(context));
+}
 
-            return statement;
-        }
-    } 
+int node_is_expression(AstNode* node) {
+    switch (node->type) {
+        case AstNodeType_PrimaryExpression:
+        case AstNodeType_IfExpression:
+        case AstNodeType_BinaryOperator:
+        case AstNodeType_UnaryOperator:
+        case AstNodeType_Asm:
+        case AstNodeType_StructLiteral:
+        case AstNodeType_FieldAccess:
+        case AstNodeType_ArrayLiteral:
+        case AstNodeType_Index:
+            return 1;
+        default:
+            return 0;
+    }
 }
 
 AstNode* parse_block(ParserContext* context) {
@@ -139,6 +489,11 @@ AstNode* parse_block(ParserContext* context) {
                 return body;
             default: {
                 AstNode* statement = parse_statement(context);
+                if (current_token(context)->type == TokenType_RBrace && node_is_expression(statement)) {
+                    body->data.block.value = statement;
+                    break;
+                }
+
                 list_push(
                     AstNode*,
                     &body->data.block.statement_list,
@@ -149,7 +504,74 @@ AstNode* parse_block(ParserContext* context) {
     }
 }
 
-// fn: fn [symbol]() [params]*
+// attributes: [symbol]*
+static int parse_fn_attributes(ParserContext* context) {
+    static struct {
+        char* name;
+        FnAttribute attribute;
+    } names[] = {
+        { "noinstrument", FnAttribute_NoInstrument },
+        { "interrupt", FnAttribute_Interrupt },
+        { "inline", FnAttribute_Inline },
+        { "noinline", FnAttribute_NoInline },
+        { "always_inline", FnAttribute_AlwaysInline },
+        { "flatten", FnAttribute_Flatten },
+        { "hot", FnAttribute_Hot },
+        { "cold", FnAttribute_Cold },
+        { "pure", FnAttribute_Pure },
+    };
+
+    // pairs that cannot both hold
+    static struct {
+        FnAttribute a;
+        FnAttribute b;
+    } conflicts[] = {
+        { FnAttribute_NoInline, FnAttribute_Inline },
+        { FnAttribute_NoInline, FnAttribute_AlwaysInline },
+        { FnAttribute_Hot, FnAttribute_Cold },
+    };
+
+    int attributes = 0;
+    Token* first = current_token(context);
+
+    while (current_token(context)->type == TokenType_Symbol) {
+        Token* token = current_token(context);
+        consume_token(context);
+
+        int found = 0;
+        for (int i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+            if (token_symbol_compare(context->source, token, names[i].name)) {
+                attributes |= names[i].attribute;
+                found = 1;
+                break;
+            }
+        }
+
+        if (!found) {
+            sil_panic(
+                "Unknown function attribute %.*s (%d:%d)",
+                token->end - token->start,
+                context->source.data + token->start,
+                token->position.line,
+                token->position.column
+            );
+        }
+    }
+
+    for (int i = 0; i < sizeof(conflicts) / sizeof(conflicts[0]); i++) {
+        if ((attributes & conflicts[i].a) && (attributes & conflicts[i].b)) {
+            sil_panic(
+                "Conflicting function attributes (%d:%d)",
+                first->position.line,
+                first->position.column
+            );
+        }
+    }
+
+    return attributes;
+}
+
+// fn: fn [symbol]() [params]* [-> type] [attributes]
 static AstNode* parse_fn_proto(ParserContext* context) {
     AstNode* fn_proto = node_new(AstNodeType_FnProto);
 
@@ -188,6 +610,8 @@ static AstNode* parse_fn_proto(ParserContext* context) {
     }
     fn_proto->data.fn_proto.return_type = return_type;
 
+    fn_proto->data.fn_proto.attributes = parse_fn_attributes(context);
+
     return fn_proto;
 }
 
@@ -213,6 +637,87 @@ static AstNode* parse_extern_fn(ParserContext* context) {
     return extern_fn;
 }
 
+// attributes: [packed | align(N) | cacheline]* on a struct, [hot | align(N) | cacheline]* on a field
+static void parse_layout_attributes(ParserContext* context, int is_field, int* attributes, unsigned int* align) {
+    while (current_token(context)->type == TokenType_Symbol) {
+        Token* token = current_token(context);
+
+        if (!is_field && token_symbol_compare(context->source, token, "packed")) {
+            consume_token(context);
+            *attributes |= LayoutAttribute_Packed;
+        } else if (is_field && token_symbol_compare(context->source, token, "hot")) {
+            consume_token(context);
+            *attributes |= LayoutAttribute_Hot;
+        } else if (token_symbol_compare(context->source, token, "cacheline")) {
+            consume_token(context);
+            *attributes |= LayoutAttribute_Cacheline;
+        } else if (token_symbol_compare(context->source, token, "align")) {
+            consume_token(context);
+            expect_token(context, TokenType_LParen);
+            Token* value = expect_token(context, TokenType_NumberLiteral);
+            expect_token(context, TokenType_RParen);
+
+            *align = atoi(context->source.data + value->start);
+            if (*align == 0 || (*align & (*align - 1)) != 0) {
+                sil_panic("Alignment must be a power of two (%d:%d)", value->position.line, value->position.column);
+            }
+        } else {
+            sil_panic(
+                "Unknown layout attribute %.*s (%d:%d)",
+                token->end - token->start,
+                context->source.data + token->start,
+                token->position.line,
+                token->position.column
+            );
+        }
+    }
+}
+
+// struct: [extern] struct name [attributes] { [name: type [attributes]],* }
+static AstNode* parse_struct(ParserContext* context) {
+    AstNode* node = node_new(AstNodeType_Struct);
+    AstNodeStruct* declaration = &node->data.struct_declaration;
+
+    if (current_token(context)->type == TokenType_KeywordExtern) {
+        consume_token(context);
+        declaration->attributes |= LayoutAttribute_Extern;
+    }
+
+    expect_token(context, TokenType_KeywordStruct);
+
+    Token* name_token = expect_token(context, TokenType_Symbol);
+    declaration->name = string_from_token(context->source.data, name_token);
+
+    parse_layout_attributes(context, 0, &declaration->attributes, &declaration->align);
+
+    expect_token(context, TokenType_LBrace);
+
+    while (current_token(context)->type != TokenType_RBrace) {
+        AstNode* field = node_new(AstNodeType_StructField);
+
+        Token* field_token = expect_token(context, TokenType_Symbol);
+        field->data.struct_field.name = string_from_token(context->source.data, field_token);
+        expect_token(context, TokenType_Colon);
+        field->data.struct_field.type = parse_type_name(context);
+        parse_layout_attributes(context, 1, &field->data.struct_field.attributes, &field->data.struct_field.align);
+
+        list_push(AstNode*, &declaration->fields, &field);
+
+        if (current_token(context)->type != TokenType_Comma) {
+            break;
+        }
+        consume_token(context);
+    }
+
+    expect_token(context, TokenType_RBrace);
+
+    if (declaration->fields.length == 0) {
+        sil_panic("Struct %.*s has no fields (%d:%d)", declaration->name.length, declaration->name.data, name_token->position.line, name_token->position.column);
+    }
+
+    return node;
+}
+
 static AstNode* parse_root(ParserContext* context) {
     AstNode* root = node_new(AstNodeType_Root);
     while (1) {
@@ -223,25 +728,39 @@ static AstNode* parse_root(ParserContext* context) {
                 break;
             }
             case TokenType_KeywordExtern: {
+                Token* next_token = list_get(Token, context->token_list, context->token_index + 1);
+                if (next_token->type == TokenType_KeywordStruct) {
+                    AstNode* declaration = parse_struct(context);
+                    list_push(AstNode*, &root->data.root.type_list, &declaration);
+                    break;
+                }
+
                 AstNode* extern_fn = parse_extern_fn(context);
                 list_push(AstNode*, &root->data.root.function_list, &extern_fn);
                 break;
             }
+            case TokenType_KeywordStruct: {
+                AstNode* declaration = parse_struct(context);
+                list_push(AstNode*, &root->data.root.type_list, &declaration);
+                break;
+            }
             case TokenType_Eof:
                 return root;
             default:
-                sil_panic("Expected function declaration");
+                sil_panic("Expected function or struct declaration");
         }
     }
 }
 
 AstNode* parse(String source, List* token_list) {
-    ParserContext context;
+    ParserContext context = {0};
     context.source = source;
     context.token_list = token_list;
     context.token_index = 0;
 
     AstNode* root = parse_root(&context);
+    root->data.root.symbol_count = context.symbol_count;
+    map_delete(&context.symbols);
 
     return root;
 }
@@ -250,6 +769,9 @@ void parser_print_ast(AstNode *node) {
     switch (node->type) {
         case AstNodeType_Root:
             printf("\n--Root--\n");
+            for (int i = 0; i < node->data.root.type_list.length; i++) {
+                parser_print_ast(*list_get(AstNode*, &node->data.root.type_list, i));
+            }
             for (int i = 0; i < node->data.root.function_list.length; i++) {
                 parser_print_ast(*list_get(AstNode*, &node->data.root.function_list, i));
             }
@@ -274,6 +796,23 @@ void parser_print_ast(AstNode *node) {
             parser_print_ast(node->data.fn.prototype);
             parser_print_ast(node->data.fn.body);
             break;
+        case AstNodeType_Struct: {
+            printf("\n--Struct Declaration--\n");
+            printf(
+                "name: %.*s\n",
+                node->data.struct_declaration.name.length,
+                node->data.struct_declaration.name.data
+            );
+            List* fields = &node->data.struct_declaration.fields;
+            for (int i = 0; i < fields->length; i++) {
+                AstNode* field = *list_get(AstNode*, fields, i);
+                printf("field %d: %.*s\n", i,
+                    field->data.struct_field.name.length,
+                    field->data.struct_field.name.data
+                );
+            }
+            break;
+        }
         case AstNodeType_FnProto: {
             List* parameters = &node->data.fn_proto.parameters;
             for (int i = 0; i < parameters->length; i++) {
@@ -292,21 +831,102 @@ void parser_print_ast(AstNode *node) {
                 AstNode* statement = *list_get(AstNode*, &block->statement_list, i);
                 parser_print_ast(statement);
             }
+            if (block->value != NULL) {
+                parser_print_ast(block->value);
+            }
+            break;
+        case AstNodeType_Asm:
+            printf(
+                "\t\tasm: %.*s\n",
+                node->data.asm_expression.template.length,
+                node->data.asm_expression.template.data
+            );
             break;
         case AstNodeType_StatementExpression:
             printf(">\texpression statement\n");
             parser_print_ast(node->data.statement_expression.expression);
             break;
         case AstNodeType_StatementReturn:
-            printf("\t\treturn statement: \n");
+            printf("\t\treturn statement:%s\n", node->data.statement_return.is_tail ? " tail" : "");
             parser_print_ast(node->data.statement_return.expression);
             break;
+        case AstNodeType_StatementLet:
+            printf(
+                "\t\tlet statement: %.*s\n",
+                node->data.statement_let.name.length,
+                node->data.statement_let.name.data
+            );
+            parser_print_ast(node->data.statement_let.value);
+            break;
+        case AstNodeType_StatementFor:
+            printf(
+                "\t\tfor statement: %.*s\n",
+                node->data.statement_for.name.length,
+                node->data.statement_for.name.data
+            );
+            parser_print_ast(node->data.statement_for.body);
+            break;
+        case AstNodeType_StatementWhile:
+            printf("\t\twhile statement\n");
+            parser_print_ast(node->data.statement_while.body);
+            break;
+        case AstNodeType_StatementBreak:
+            printf("\t\tbreak statement\n");
+            break;
+        case AstNodeType_StatementContinue:
+            printf("\t\tcontinue statement\n");
+            break;
+        case AstNodeType_StatementAssign:
+            if (node->data.statement_assign.target != NULL) {
+                printf("\t\tassign statement: place\n");
+                parser_print_ast(node->data.statement_assign.target);
+            } else {
+                printf(
+                    "\t\tassign statement: %.*s\n",
+                    node->data.statement_assign.name.length,
+                    node->data.statement_assign.name.data
+                );
+            }
+            parser_print_ast(node->data.statement_assign.value);
+            break;
         case AstNodeType_PrimaryExpression:
             printf("\t\tprimary expression\n");
             break;
+        case AstNodeType_StructLiteral:
+            printf(
+                "\t\tstruct literal: %.*s\n",
+                node->data.struct_literal.name.length,
+                node->data.struct_literal.name.data
+            );
+            break;
+        case AstNodeType_FieldAccess:
+            printf(
+                "\t\tfield access: .%.*s\n",
+                node->data.field_access.field.length,
+                node->data.field_access.field.data
+            );
+            parser_print_ast(node->data.field_access.value);
+            break;
+        case AstNodeType_ArrayLiteral:
+            printf("\t\tarray literal: %zu elements\n", node->data.array_literal.elements.length);
+            break;
+        case AstNodeType_Index:
+            printf(node->data.index.end != NULL ? "\t\tslice\n" : "\t\tindex\n");
+            parser_print_ast(node->data.index.value);
+            break;
         case AstNodeType_BinaryOperator:
             printf(">\tInfix operator:\n");
             break;
+        case AstNodeType_UnaryOperator:
+            printf(">\tPrefix operator:\n");
+            break;
+        case AstNodeType_IfExpression:
+            printf(">\tIf expression:\n");
+            parser_print_ast(node->data.if_expression.body);
+            if (node->data.if_expression.alt != NULL) {
+                parser_print_ast(node->data.if_expression.alt);
+            }
+            break;
             
         default:
             printf("Unknown AST Node: %d\n", node->type);
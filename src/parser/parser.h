@@ -2,6 +2,7 @@
 #define PARSER_H
 
 #include "expression.h"
+#include "hashmap.h"
 #include "lexer/lexer.h"
 #include "list.h"
 #include "string_buffer.h"
@@ -12,6 +13,9 @@ typedef struct ParserContext {
     String source;
     List* token_list;
     int token_index;
+    // local names interned to dense ids for the codegen symbol table
+    HashMap symbols;
+    unsigned int symbol_count;
 } ParserContext;
 
 typedef enum AstNodeType {
@@ -23,40 +27,77 @@ typedef enum AstNodeType {
     AstNodeType_FnProto,
     AstNodeType_Block,
     AstNodeType_StatementReturn,
+    AstNodeType_StatementLet,
+    AstNodeType_StatementAssign,
+    AstNodeType_StatementFor,
+    AstNodeType_StatementWhile,
+    AstNodeType_StatementBreak,
+    AstNodeType_StatementContinue,
     AstNodeType_StatementExpression,
     AstNodeType_PrimaryExpression,
     AstNodeType_IfExpression,
     AstNodeType_BinaryOperator,
     AstNodeType_UnaryOperator,
+    AstNodeType_Asm,
+    AstNodeType_Struct,
+    AstNodeType_StructField,
+    AstNodeType_StructLiteral,
+    AstNodeType_FieldAccess,
+    AstNodeType_ArrayLiteral,
+    AstNodeType_Index,
 } AstNodeType;
 
 typedef enum AstTypeName {
     AstTypeName_unreachable,
     AstTypeName_void,
-    AstTypeName_i8,
-    AstTypeName_u8,
-    AstTypeName_i32,
+    AstTypeName_bool,
+    AstTypeName_int,
+    AstTypeName_isize,
+    AstTypeName_usize,
+    AstTypeName_f32,
+    AstTypeName_f64,
 } AstTypeName;
 
 typedef struct AstNode AstNode;
 
 typedef struct AstNodeRoot {
     List function_list;
+    // struct declarations, in source order
+    List type_list;
+    unsigned int symbol_count;
 } AstNodeRoot;
 
 typedef enum AstNodeTypeNameType {
     AstNodeTypeNameType_Primitive,
     AstNodeTypeNameType_Pointer,
+    AstNodeTypeNameType_Vector,
+    // a struct, looked up by name during codegen
+    AstNodeTypeNameType_Named,
+    // [length]child_type, or @soa [length]child_type
+    AstNodeTypeNameType_Array,
+    // []child_type or []const child_type
+    AstNodeTypeNameType_Slice,
 } AstNodeTypeNameType;
 
 typedef struct AstNodeTypeName {
     AstNodeTypeNameType type;
     AstTypeName primitive;
+    // width and signedness of AstTypeName_int, from iN or uN
+    unsigned int bits;
+    int is_signed;
+    // lane count of @Vector(lanes, child_type)
+    unsigned int lanes;
+    unsigned int length;
+    // each field of the struct elements is stored as its own array
+    int is_soa;
+    int is_const;
     AstNode* child_type;
+    String name;
 } AstNodeTypeName;
 
 typedef struct AstNodePattern {
     String name;
+    unsigned int symbol;
     AstNode* type;
 } AstNodePattern;
 
@@ -69,13 +110,54 @@ typedef struct AstNodeFn {
     AstNode* body;
 } AstNodeFn;
 
+typedef enum FnAttribute {
+    FnAttribute_NoInstrument = 1 << 0,
+    FnAttribute_Interrupt = 1 << 1,
+    FnAttribute_Inline = 1 << 2,
+    FnAttribute_NoInline = 1 << 3,
+    FnAttribute_AlwaysInline = 1 << 4,
+    // every call in the body is inlined
+    FnAttribute_Flatten = 1 << 5,
+    FnAttribute_Hot = 1 << 6,
+    FnAttribute_Cold = 1 << 7,
+    // reads but never writes memory, and always returns
+    FnAttribute_Pure = 1 << 8,
+} FnAttribute;
+
 typedef struct AstNodeFnProto {
     String name;
     AstNode* return_type;
     List parameters;
+    int attributes;
     LLVMTypeRef llvm_fn_type;
 } AstNodeFnProto;
 
+typedef enum LayoutAttribute {
+    // no padding between fields, alignment 1
+    LayoutAttribute_Packed = 1 << 0,
+    // aligned to the target's cache line, so nothing else shares it
+    LayoutAttribute_Cacheline = 1 << 1,
+    // extern struct: fields stay in declaration order, as C lays them out
+    LayoutAttribute_Extern = 1 << 2,
+    // a field placed ahead of the others, near the start of the struct
+    LayoutAttribute_Hot = 1 << 3,
+} LayoutAttribute;
+
+typedef struct AstNodeStruct {
+    String name;
+    List fields;
+    int attributes;
+    // from align(N), 0 when unset
+    unsigned int align;
+} AstNodeStruct;
+
+typedef struct AstNodeStructField {
+    String name;
+    AstNode* type;
+    int attributes;
+    unsigned int align;
+} AstNodeStructField;
+
 typedef struct AstNodeFnParam {
     String name;
     AstNode* type;
@@ -83,12 +165,58 @@ typedef struct AstNodeFnParam {
 
 typedef struct AstNodeBlock {
     List statement_list;
+    // trailing expression without a semicolon, or NULL
+    AstNode* value;
 } AstNodeBlock;
 
 typedef struct AstNodeStatementReturn {
     AstNode* expression;
+    // return tail f(x): the call must reuse the caller's frame
+    int is_tail;
 } AstNodeStatementReturn;
 
+typedef struct AstNodeStatementLet {
+    String name;
+    unsigned int symbol;
+    AstNode* type;
+    AstNode* value;
+    int is_mutable;
+} AstNodeStatementLet;
+
+typedef struct AstNodeStatementAssign {
+    String name;
+    unsigned int symbol;
+    // p.x = value assigns to a place, otherwise NULL
+    AstNode* target;
+    AstNode* value;
+} AstNodeStatementAssign;
+
+// Optimizer hints written after a loop header, e.g. #unroll(4).
+typedef struct AstLoopHints {
+    // keeps every iteration, for delay loops
+    int is_volatile;
+    // 0 unset, -1 full, otherwise the unroll count
+    int unroll;
+    // 0 unset, 1 disables vectorization, otherwise the width
+    int vectorize_width;
+} AstLoopHints;
+
+typedef struct AstNodeStatementFor {
+    String name;
+    unsigned int symbol;
+    AstNode* start;
+    AstNode* end;
+    AstNode* body;
+    AstLoopHints hints;
+} AstNodeStatementFor;
+
+// while, or loop when condition is NULL
+typedef struct AstNodeStatementWhile {
+    AstNode* condition;
+    AstNode* body;
+    AstLoopHints hints;
+} AstNodeStatementWhile;
+
 typedef struct AstNodeStatementExpression {
     AstNode* expression;
 } AstNodeStatementExpression;
@@ -116,23 +244,38 @@ typedef struct AstNode {
         AstNodeFn fn;
         AstNodeFnProto fn_proto;
         AstNodeFnParam fn_param;
+        AstNodeStruct struct_declaration;
+        AstNodeStructField struct_field;
         AstNodeBlock block;
         AstNodeStatementReturn statement_return;
+        AstNodeStatementLet statement_let;
+        AstNodeStatementAssign statement_assign;
+        AstNodeStatementFor statement_for;
+        AstNodeStatementWhile statement_while;
         AstNodeStatementExpression statement_expression;
         AstNodePrimaryExpression primary_expression;
         AstNodeIfExpression if_expression;
         AstNodeInfixOperator binary_operator;
         AstNodeUnaryOperator unary_operator;
+        AstNodeAsm asm_expression;
+        AstNodeStructLiteral struct_literal;
+        AstNodeFieldAccess field_access;
+        AstNodeArrayLiteral array_literal;
+        AstNodeIndex index;
     } data;
 } AstNode;
 
 void consume_token(ParserContext* context);
 Token* current_token(ParserContext* context);
 Token* expect_token(ParserContext* context, TokenType type);
+unsigned int expect_count(ParserContext* context, const char* what);
 AstNode* node_new(AstNodeType type);
+unsigned int intern_symbol(ParserContext* context, String name);
 
 AstNode* parse(String source, List* token_list);
 AstNode* parse_block(ParserContext* context);
+AstNode* parse_type_name(ParserContext* context);
+int node_is_expression(AstNode* node);
 
 void parser_print_ast(AstNode* node);
 
@@ -1,6 +1,7 @@
 #include "string_buffer.h"
 
 #include "lexer/lexer.h"
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -24,11 +25,26 @@ String string_from_token(char* buffer, Token* token) {
     );
 }
 
+unsigned int string_hash(const String string) {
+    // FNV 32-bit hash
+    unsigned int h = 2166136261;
+    for (int i = 0; i < string.length; i += 1) {
+        h = h ^ ((unsigned char)*(string.data + i));
+        h = h * 16777619;
+    }
+
+    return h;
+}
+
 void string_delete(String a) {
     free(a.data);
 }
 
 int string_compare(const String a, const String b) {
+    if (a.length != b.length) {
+        return 0;
+    }
+
     for (int i = 0; i < a.length; i++) {
         if (a.data[i] != b.data[i]) {
             return 0;
@@ -47,3 +63,38 @@ int string_compare_literal(const String a, const char* b) {
 
     return 1;
 }
+
+int string_to_integer(const String string, unsigned long long* value) {
+    int base = 10;
+    int i = 0;
+    if (string.length > 2 && string.data[0] == '0' && (string.data[1] == 'x' || string.data[1] == 'b')) {
+        base = string.data[1] == 'x' ? 16 : 2;
+        i = 2;
+    }
+
+    int digit_count = 0;
+    *value = 0;
+    for (; i < string.length; i++) {
+        char c = string.data[i];
+        if (c == '_') {
+            continue;
+        }
+
+        unsigned int digit = base;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        }
+        if (digit >= base || *value > (ULLONG_MAX - digit) / base) {
+            return 0;
+        }
+
+        *value = *value * base + digit;
+        digit_count++;
+    }
+
+    return digit_count > 0;
+}
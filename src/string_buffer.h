@@ -13,9 +13,13 @@ typedef struct Token Token;
 String string_from_literal(char* literal);
 String string_from_buffer(char* start, const size_t length);
 String string_from_token(char* buffer, Token* token);
+unsigned int string_hash(const String string);
 void string_delete(String a);
 int string_compare(const String a, const String b);
 int string_compare_literal(const String a, const char* b);
+// An integer literal: decimal, 0x hex or 0b binary, with _ separators.
+// Returns 0 when it is malformed or does not fit in 64 bits.
+int string_to_integer(const String string, unsigned long long* value);
 
 
 #endif // !STRING_H
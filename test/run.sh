@@ -0,0 +1,146 @@
+#!/bin/sh
+# Compiles every test/*.sil, or the files given, and checks the directives in
+# its comments:
+#
+#   // flags: <options>    passed to sil
+#   // link: <file.c>      compiled and linked into the program
+#   // error: <text>       compiling fails and prints text
+#   // ir: <text>          the compiler's output (IR dump and reports) has text
+#   // not-ir: <text>      the compiler's output does not have text
+#   // stdout: <text>      the program prints this line, checked in order
+#   // exit: <code>        the program exits with code
+#   // trap                the program is killed by a trap
+#   // profile-ir: <text>  the profile the program wrote is merged, and a
+#                          build with --profile-use has text in its
+#                          optimized IR
+#
+# A test with no stdout, exit or trap directive is only compiled.
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+sil="$root/sil"
+profdata="$(llvm-config --bindir)/llvm-profdata"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+if [ $# -eq 0 ]; then
+    set -- "$root"/test/*.sil
+fi
+
+directives() {
+    sed -n "s|^ *// $1: *||p" "$2"
+}
+
+passed=0
+failed=0
+
+fail() {
+    echo "FAIL $name: $1"
+    failed=$((failed + 1))
+}
+
+for test in "$@"; do
+    test=$(cd "$(dirname "$test")" && pwd)/$(basename "$test")
+    name=$(basename "$test" .sil)
+    flags=$(directives flags "$test")
+
+    # flags are split on spaces, like on the command line
+    (cd "$work" && "$sil" "$test" --output "$work/$name.o" $flags) > "$work/compile.log" 2>&1
+    status=$?
+
+    error=$(directives error "$test")
+    if [ -n "$error" ]; then
+        if [ $status -eq 0 ]; then
+            fail "compiled, expected error: $error"
+        elif ! grep -aqF -- "$error" "$work/compile.log"; then
+            fail "missing error: $error"
+        else
+            passed=$((passed + 1))
+        fi
+        continue
+    fi
+    if [ $status -ne 0 ]; then
+        fail "compile failed"
+        tail -n 5 "$work/compile.log"
+        continue
+    fi
+
+    missing=$(directives ir "$test" | while IFS= read -r text; do
+        grep -aqF -- "$text" "$work/compile.log" || echo "$text"
+    done)
+    if [ -n "$missing" ]; then
+        fail "missing in compiler output: $missing"
+        continue
+    fi
+
+    unexpected=$(directives not-ir "$test" | while IFS= read -r text; do
+        grep -aqF -- "$text" "$work/compile.log" && echo "$text"
+    done)
+    if [ -n "$unexpected" ]; then
+        fail "unexpected in compiler output: $unexpected"
+        continue
+    fi
+
+    expected_exit=$(directives exit "$test")
+    if [ -z "$expected_exit" ] && [ -z "$(directives stdout "$test")" ] && ! grep -q "^ *// trap" "$test"; then
+        passed=$((passed + 1))
+        continue
+    fi
+
+    links=$(directives link "$test" | sed "s|^|$root/|")
+    if ! cc -no-pie -o "$work/$name" "$work/$name.o" $links > "$work/link.log" 2>&1; then
+        fail "link failed"
+        tail -n 5 "$work/link.log"
+        continue
+    fi
+
+    # the status is read in the subshell, which also reports a trap on stderr
+    (cd "$work" && LLVM_PROFILE_FILE="$work/$name.profraw" "./$name" > "$work/stdout"; echo $? > "$work/status") 2> /dev/null
+    status=$(cat "$work/status")
+
+    if grep -q "^ *// trap" "$test"; then
+        if [ $status -le 128 ]; then
+            fail "exited with $status, expected a trap"
+            continue
+        fi
+    elif [ $status -ne "${expected_exit:-0}" ]; then
+        fail "exited with $status, expected ${expected_exit:-0}"
+        continue
+    fi
+
+    directives stdout "$test" > "$work/expected"
+    if [ -s "$work/expected" ] && ! diff -u "$work/expected" "$work/stdout" > "$work/stdout.diff"; then
+        fail "unexpected output"
+        cat "$work/stdout.diff"
+        continue
+    fi
+
+    if [ -n "$(directives profile-ir "$test")" ]; then
+        if ! "$profdata" merge -o "$work/$name.profdata" "$work/$name.profraw" > "$work/merge.log" 2>&1; then
+            fail "llvm-profdata merge failed"
+            tail -n 5 "$work/merge.log"
+            continue
+        fi
+
+        # the same build, reading the profile instead of writing one
+        use_flags=$(echo "$flags" | sed 's/--profile-generate[^ ]*//g')
+        if ! (cd "$work" && "$sil" "$test" --output "$work/$name.o" $use_flags \
+            --profile-use="$work/$name.profdata" --emit-ir="$work/$name.ll") > "$work/compile.log" 2>&1; then
+            fail "profile-use build failed"
+            tail -n 5 "$work/compile.log"
+            continue
+        fi
+
+        missing=$(directives profile-ir "$test" | while IFS= read -r text; do
+            grep -aqF -- "$text" "$work/$name.ll" || echo "$text"
+        done)
+        if [ -n "$missing" ]; then
+            fail "missing in profile-use IR: $missing"
+            continue
+        fi
+    fi
+
+    passed=$((passed + 1))
+done
+
+echo "$passed passed, $failed failed"
+[ $failed -eq 0 ]